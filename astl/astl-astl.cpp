@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2019 Andreas Franz Borchert
+   Copyright (C) 2009-2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -25,6 +25,7 @@
 #include <memory>
 #include <astl/generator.hpp>
 #include <astl/loader.hpp>
+#include <astl/module-cache.hpp>
 #include <astl/location.hpp>
 #include <astl/operators.hpp>
 #include <astl/parser.hpp>
@@ -88,6 +89,7 @@ int main(int argc, char** argv) {
 	 loader.add_library("/usr/share/astl/astl");
 #endif
       }
+      loader.set_cache_directory(default_module_cache_directory());
       run(argc, argv, astgen, loader, Op::LPAREN);
    } catch (Exception& e) {
       cout << endl;
@@ -135,6 +137,16 @@ directories to the library search path using the Astl
 library clause (see section 12.1 in the I<Report of the
 Astl Programming Language>).
 
+Parsed scripts and library modules are cached in the directory
+given by the environment variable I<ASTL_ASTL_CACHE>. If this variable
+is not set, F<$XDG_CACHE_HOME/astl> or F<$HOME/.cache/astl> is used.
+Setting I<ASTL_ASTL_CACHE> to an empty string disables the cache.
+
+If the environment variable I<ASTL_SHARE_SUBTREES> is set to a
+non-empty value, structurally equal subtrees of the abstract syntax
+tree are shared when mutations are generated
+(see section 13.3 of the I<Report of the Astl Programming Language>).
+
 =head1 AUTHOR
 
 Andreas F. Borchert
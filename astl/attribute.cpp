@@ -402,7 +402,7 @@ AttributePtr Attribute::convert_to_list() {
       FlowGraphNodePtr fgn = get_fgnode();
       for (FlowGraphNode::Iterator it = fgn->begin_links();
 	    it != fgn->end_links(); ++it) {
-	 l->push_back(std::make_shared<Attribute>(it->second));
+	 l->push_back(std::make_shared<Attribute>(it->node));
       }
       return l;
    }
@@ -0,0 +1,63 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <astl/binary-coding.hpp>
+#include <astl/exception.hpp>
+
+namespace Astl {
+
+MappedFile::MappedFile(const std::string& path) : mem(nullptr), len(0) {
+   int fd = open(path.c_str(), O_RDONLY);
+   struct stat sb;
+   if (fd < 0 || fstat(fd, &sb) < 0) {
+      if (fd >= 0) close(fd);
+      std::ostringstream os;
+      os << "unable to open " << path;
+      throw Exception(os.str());
+   }
+   len = sb.st_size;
+   if (len > 0) {
+      mem = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+   }
+   close(fd);
+   if (len == 0 || mem == MAP_FAILED) {
+      mem = nullptr;
+      std::ostringstream os;
+      os << "unable to read " << path;
+      throw Exception(os.str());
+   }
+}
+
+MappedFile::~MappedFile() {
+   munmap(mem, len);
+}
+
+std::uint64_t fnv1a(const char* s, std::size_t len, std::uint64_t hash) {
+   for (std::size_t i = 0; i < len; ++i) {
+      hash ^= (unsigned char) s[i];
+      hash *= 0x100000001b3;
+   }
+   return hash;
+}
+
+} // namespace Astl
@@ -0,0 +1,193 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_BINARY_CODING_H
+#define ASTL_BINARY_CODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Astl {
+
+   /**
+    * Support for the binary formats of syntax trees. Integers are
+    * encoded as varints with 7 bits per byte, least significant group
+    * first. Strings are encoded by their length followed by their bytes.
+    */
+
+   /* thrown when binary data turns out to be truncated or corrupted */
+   struct MalformedBinaryData {};
+
+   /* signed integers are mapped to unsigned integers such
+      that small absolute values get short encodings */
+   inline std::uint64_t zigzag(std::int64_t val) {
+      return (std::uint64_t(val) << 1) ^ std::uint64_t(val >> 63);
+   }
+
+   inline std::int64_t unzigzag(std::uint64_t val) {
+      return std::int64_t(val >> 1) ^ -std::int64_t(val & 1);
+   }
+
+   class BinaryEncoder {
+      public:
+	 void put(std::uint64_t val) {
+	    while (val >= 0x80) {
+	       buf.push_back(char((val & 0x7f) | 0x80)); val >>= 7;
+	    }
+	    buf.push_back(char(val));
+	 }
+	 void put_signed(std::int64_t val) {
+	    put(zigzag(val));
+	 }
+	 void put_raw(const char* s, std::size_t len) {
+	    buf.append(s, len);
+	 }
+	 void put(const std::string& s) {
+	    put(s.size()); buf.append(s);
+	 }
+	 const std::string& get_buffer() const {
+	    return buf;
+	 }
+      private:
+	 std::string buf;
+   };
+
+   class BinaryDecoder {
+      public:
+	 BinaryDecoder() : pos(nullptr), end(nullptr) {
+	 }
+	 BinaryDecoder(const char* begin, const char* end) :
+	       pos(begin), end(end) {
+	 }
+	 std::uint64_t get() {
+	    std::uint64_t val = 0;
+	    for (unsigned int shift = 0; shift < 64; shift += 7) {
+	       if (pos == end) throw MalformedBinaryData();
+	       unsigned char byte = *pos++;
+	       val |= std::uint64_t(byte & 0x7f) << shift;
+	       if ((byte & 0x80) == 0) return val;
+	    }
+	    throw MalformedBinaryData();
+	 }
+	 std::int64_t get_signed() {
+	    return unzigzag(get());
+	 }
+	 const char* get_raw(std::size_t len) {
+	    if (std::size_t(end - pos) < len) throw MalformedBinaryData();
+	    const char* s = pos; pos += len;
+	    return s;
+	 }
+	 std::string get_string() {
+	    std::size_t len = get();
+	    return std::string(get_raw(len), len);
+	 }
+	 /* number of entries which take at least min_len bytes
+	    each such that corrupted counts are detected before
+	    any space is allocated for them */
+	 std::size_t get_count(std::size_t min_len) {
+	    std::uint64_t count = get();
+	    if (count > remaining() / min_len) throw MalformedBinaryData();
+	    return count;
+	 }
+	 /* index into a table with the given number of entries */
+	 std::size_t get_index(std::size_t size) {
+	    std::uint64_t index = get();
+	    if (index >= size) throw MalformedBinaryData();
+	    return index;
+	 }
+	 /* section of the given length that is to be decoded separately */
+	 BinaryDecoder get_section(std::size_t len) {
+	    const char* begin = get_raw(len);
+	    return BinaryDecoder(begin, begin + len);
+	 }
+	 bool at_end() const {
+	    return pos == end;
+	 }
+	 std::size_t remaining() const {
+	    return end - pos;
+	 }
+      private:
+	 const char* pos;
+	 const char* end;
+   };
+
+   /* collects the strings of a tree while it is encoded */
+   class BinaryStringTable {
+      public:
+	 BinaryStringTable() :
+	       last_filename(nullptr), last_filename_index(0) {
+	 }
+	 std::size_t add(const std::string& s) {
+	    auto it = index.find(s);
+	    if (it != index.end()) return it->second;
+	    std::size_t i = strings.size();
+	    index[s] = i; strings.push_back(s);
+	    return i;
+	 }
+	 /* filenames of positions are usually shared */
+	 std::size_t add_filename(const std::string& filename) {
+	    if (&filename != last_filename) {
+	       last_filename = &filename;
+	       last_filename_index = add(filename);
+	    }
+	    return last_filename_index;
+	 }
+	 const std::vector<std::string>& get_strings() const {
+	    return strings;
+	 }
+	 void encode(BinaryEncoder& enc) const {
+	    enc.put(strings.size());
+	    for (auto& s: strings) {
+	       enc.put(s);
+	    }
+	 }
+      private:
+	 std::unordered_map<std::string, std::size_t> index;
+	 std::vector<std::string> strings;
+	 const std::string* last_filename;
+	 std::size_t last_filename_index;
+   };
+
+   /* read-only mapping of an entire file into memory;
+      an exception is thrown if the file cannot be mapped */
+   class MappedFile {
+      public:
+	 MappedFile(const std::string& path);
+	 ~MappedFile();
+	 MappedFile(const MappedFile&) = delete;
+	 MappedFile& operator=(const MappedFile&) = delete;
+	 const char* begin() const {
+	    return static_cast<const char*>(mem);
+	 }
+	 std::size_t size() const {
+	    return len;
+	 }
+      private:
+	 void* mem;
+	 std::size_t len;
+   };
+
+   std::uint64_t fnv1a(const char* s, std::size_t len,
+      std::uint64_t hash = 0xcbf29ce484222325);
+
+} // namespace Astl
+
+#endif
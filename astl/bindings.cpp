@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -22,17 +22,25 @@
 
 namespace Astl {
 
-Bindings::Bindings() : it_defined(false), rules(nullptr) {
+Bindings::Bindings() : it_defined(false), immutable(false), rules(nullptr) {
 }
 
-Bindings::Bindings(const Rules* rulesp) : it_defined(false), rules(rulesp) {
+Bindings::Bindings(const Rules* rulesp) :
+      it_defined(false), immutable(false), rules(rulesp) {
 }
 
 Bindings::Bindings(BindingsPtr outer_scope) :
-      it_defined(false), uplink(outer_scope), rules(outer_scope->rules) {
+      it_defined(false), immutable(false),
+      uplink(outer_scope), rules(outer_scope->rules) {
+}
+
+Bindings::Bindings(BindingsPtr outer_scope, const Rules* rulesp) :
+      it_defined(false), immutable(false),
+      uplink(outer_scope), rules(rulesp) {
 }
 
 bool Bindings::define(const std::string& name, AttributePtr value) {
+   assert(!immutable);
    std::pair<Map::iterator, bool> result = vars.insert(make_pair(name, value));
    if (result.second) {
       it = result.first; it_defined = true;
@@ -73,6 +81,17 @@ bool Bindings::merge(BindingsPtr bindings) {
    return true;
 }
 
+bool Bindings::merge_clones(BindingsPtr bindings) {
+   for (auto& var: bindings->vars) {
+      AttributePtr value = var.second;
+      if (value) value = value->clone();
+      if (!define(var.first, value)) {
+	 return false;
+      }
+   }
+   return true;
+}
+
 void Bindings::mk_const(const std::string& name) {
    assert(defined(name));
    constness[name] = true;
@@ -85,6 +104,11 @@ void Bindings::mk_all_const() {
    }
 }
 
+void Bindings::mk_immutable() {
+   immutable = true;
+   it_defined = false;
+}
+
 bool Bindings::is_const(const std::string& name) const {
    std::map<std::string, bool>::const_iterator cit = constness.find(name);
    if (cit == constness.end()) {
@@ -106,7 +130,9 @@ bool Bindings::defined(const std::string& name) const {
 	 return false;
       }
    }
-   it = find_it; it_defined = true;
+   if (!immutable) {
+      it = find_it; it_defined = true;
+   }
    return true;
 }
 
@@ -117,6 +143,7 @@ AttributePtr Bindings::get(const std::string& name) const {
 	 return uplink->get(name);
       }
       assert(find_it != vars.end());
+      if (immutable) return find_it->second;
       it = find_it; it_defined = true;
    }
    return it->second;
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -36,11 +36,19 @@ namespace Astl {
 	 Bindings();
 	 Bindings(const Rules* rulesp);
 	 Bindings(BindingsPtr outer_scope);
+	 Bindings(BindingsPtr outer_scope, const Rules* rulesp);
 	 bool define(const std::string& name, AttributePtr value);
 	 bool update(const std::string& name, AttributePtr value);
 	 bool merge(BindingsPtr bindings);
+	 /* like merge but with clones of the values such that
+	    no attribute is shared with the other bindings */
+	 bool merge_clones(BindingsPtr bindings);
 	 void mk_const(const std::string& name);
 	 void mk_all_const();
+	 /* no further definitions are permitted and lookups
+	    no longer update the cache, i.e. the bindings may be
+	    shared among threads from now on */
+	 void mk_immutable();
 	 bool defined(const std::string& name) const;
 	 bool is_const(const std::string& name) const;
 	 AttributePtr get(const std::string& name) const;
@@ -54,6 +62,7 @@ namespace Astl {
 	 Map vars;
 	 mutable Map::const_iterator it;
 	 mutable bool it_defined;
+	 bool immutable;
 	 BindingsPtr uplink;
 	 std::map<std::string, bool> constness;
 	 const Rules* rules;
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2019 Andreas Franz Borchert
+   Copyright (C) 2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,8 +19,10 @@
 #ifndef ASTL_BUILTIN_PARSE_HPP
 #define ASTL_BUILTIN_PARSE_HPP
 
+#include <iostream>
 #include <memory>
 #include <sstream>
+#include <string>
 #include <astl/attribute.hpp>
 #include <astl/bindings.hpp>
 #include <astl/exception.hpp>
@@ -100,17 +102,56 @@ inline AttributePtr builtin_run_attribution_rules(BindingsPtr bindings,
 
 inline AttributePtr builtin_run_state_machines(BindingsPtr bindings,
       AttributePtr args) {
-   if (!args || args->size() != 1) {
+   if (!args || args->size() < 1 || args->size() > 2) {
       throw Exception("wrong number of arguments for "
 	 "run_state_machines function");
    }
+   /* the optional second argument is either the number of threads
+      or a dictionary with the keys threads, schedule, and statistics */
+   SMExecutionParameters parameters;
+   if (args->size() == 2) {
+      AttributePtr params_at = args->get_value(1);
+      if (!params_at) {
+	 throw Exception("non-null value expected as second argument "
+	    "of run_state_machines function");
+      }
+      Location loc;
+      AttributePtr threads_at = params_at;
+      if (params_at->get_type() == Attribute::dictionary) {
+	 threads_at = nullptr;
+	 if (params_at->is_defined("threads")) {
+	    threads_at = params_at->get_value("threads");
+	 }
+	 if (params_at->is_defined("schedule")) {
+	    AttributePtr schedule_at = params_at->get_value("schedule");
+	    std::string schedule = schedule_at?
+	       schedule_at->convert_to_string(): "";
+	    if (schedule == "rpo") {
+	       parameters.prioritized = true;
+	    } else if (schedule != "dfs") {
+	       throw Exception("unknown schedule for run_state_machines "
+		  "function: \"" + schedule + "\"");
+	    }
+	 }
+	 if (params_at->is_defined("statistics")) {
+	    AttributePtr statistics_at = params_at->get_value("statistics");
+	    if (statistics_at && statistics_at->convert_to_bool()) {
+	       parameters.statistics = &std::cerr;
+	    }
+	 }
+      }
+      if (threads_at) {
+	 parameters.threads =
+	    threads_at->convert_to_integer(loc)->get_unsigned_int(loc);
+      }
+   }
    AttributePtr at = args->get_value(0);
    if (at && at->get_type() == Attribute::tree) {
       if (bindings->rules_defined()) {
 	 BindingsPtr local_bindings(bindings);
 	 local_bindings->define("root", std::make_shared<Attribute>(at));
 	 const Rules& rules(bindings->get_rules());
-	 execute_state_machines(rules, local_bindings);
+	 execute_state_machines(rules, local_bindings, parameters);
       }
    }
    return nullptr;
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010, 2016 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2016, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,9 +16,14 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <utility>
 #include <astl/candidate-set.hpp>
+#include <astl/cloner.hpp>
 #include <astl/default-bindings.hpp>
 #include <astl/operator.hpp>
 #include <astl/tree-expressions.hpp>
@@ -28,7 +33,8 @@ namespace Astl {
 CandidateSet::CandidateSet(NodePtr root, const RuleTable& rules) :
       generated(false), root(root), suppress_conflicts(false),
       rules(rules), bindings(create_default_bindings(root)),
-      consumer(nullptr), prg(nullptr) {
+      consumer(nullptr), prg(nullptr), sample_size(0), seen(0),
+      suppress_dups(false), duplicates(0) {
    assert(root);
 }
 
@@ -36,14 +42,16 @@ CandidateSet::CandidateSet(NodePtr root, const RuleTable& rules,
 	 ConsumerPtr consumer, PseudoRandomGeneratorPtr prg) :
       generated(false), root(root), suppress_conflicts(false),
       rules(rules), bindings(create_default_bindings(root)),
-      consumer(consumer), prg(prg) {
+      consumer(consumer), prg(prg), sample_size(0), seen(0),
+      suppress_dups(false), duplicates(0) {
    assert(root);
 }
 
 CandidateSet::CandidateSet(NodePtr root, const RuleTable& rules,
 	 BindingsPtr bindings) :
       generated(false), root(root), suppress_conflicts(false),
-      rules(rules), bindings(bindings), consumer(nullptr), prg(nullptr) {
+      rules(rules), bindings(bindings), consumer(nullptr), prg(nullptr),
+      sample_size(0), seen(0), suppress_dups(false), duplicates(0) {
    assert(root);
 }
 
@@ -51,19 +59,117 @@ CandidateSet::CandidateSet(NodePtr root, const RuleTable& rules,
 	 BindingsPtr bindings,
 	 ConsumerPtr consumer, PseudoRandomGeneratorPtr prg) :
       generated(false), root(root), suppress_conflicts(false),
-      rules(rules), bindings(bindings), consumer(consumer), prg(prg) {
+      rules(rules), bindings(bindings), consumer(consumer), prg(prg),
+      sample_size(0), seen(0), suppress_dups(false), duplicates(0) {
    assert(root);
 }
 
 void CandidateSet::generate() const {
    if (!generated) {
       Context context;
+      next_index = 0;
       traverse(root, context);
+      match_results.clear();
       generated = true;
    }
 }
 
+/*
+   traverse the tree without materializing the full set of candidates
+   and keep a uniformly selected sample of at most count candidates,
+   see algorithm L in Kim-Hung Li, Reservoir-Sampling Algorithms
+   of Time Complexity O(n(1 + log(N/n))), ACM TOMS 20(4), 1994;
+   the sample is returned in the order of the traversal
+*/
+void CandidateSet::generate_sample(std::size_t count) const {
+   assert(!generated && count > 0); assert(prg);
+   candidates.clear(); sample_index.clear();
+   sample_size = count; seen = 0;
+   Context context;
+   next_index = 0;
+   traverse(root, context);
+   match_results.clear();
+   sample_size = 0;
+   std::vector<std::pair<std::size_t, CandidatePtr>> sample;
+   sample.reserve(candidates.size());
+   for (std::size_t i = 0; i < candidates.size(); ++i) {
+      sample.emplace_back(sample_index[i], candidates[i]);
+   }
+   std::sort(sample.begin(), sample.end(),
+      [](const std::pair<std::size_t, CandidatePtr>& c1,
+	    const std::pair<std::size_t, CandidatePtr>& c2) {
+	 return c1.first < c2.first;
+      });
+   for (std::size_t i = 0; i < sample.size(); ++i) {
+      candidates[i] = sample[i].second;
+   }
+   sample_index.clear();
+}
+
+/* decide whether the next matching candidate is to be kept
+   and where it is to be stored within candidates */
+bool CandidateSet::keep_candidate(std::size_t& slot) const {
+   std::size_t index = seen++;
+   if (sample_size == 0) {
+      slot = candidates.size(); return true;
+   }
+   if (index < sample_size) {
+      slot = candidates.size(); sample_index.push_back(index);
+      if (index + 1 == sample_size) {
+	 /* reservoir is filled */
+	 weight = random_weight();
+	 skip_candidates();
+      }
+      return true;
+   }
+   if (index < next_pick) return false;
+   slot = prg->pick(sample_size); sample_index[slot] = index;
+   weight *= random_weight();
+   skip_candidates();
+   return true;
+}
+
+/* return exp(log(u)/sample_size) for u uniformly from (0,1) */
+double CandidateSet::random_weight() const {
+   double u;
+   do {
+      u = prg->val();
+   } while (u <= 0);
+   return std::exp(std::log(u) / sample_size);
+}
+
+/* determine the index of the next candidate that enters the reservoir */
+void CandidateSet::skip_candidates() const {
+   double u;
+   do {
+      u = prg->val();
+   } while (u <= 0);
+   double skip = std::floor(std::log(u) / std::log1p(-weight));
+   if (skip >= std::numeric_limits<std::size_t>::max() - seen) {
+      next_pick = std::numeric_limits<std::size_t>::max();
+   } else {
+      next_pick = seen + static_cast<std::size_t>(skip);
+   }
+}
+
+/* number of nodes of a tree including all occurrences of shared subtrees */
+static std::size_t count_nodes(const NodePtr& root) {
+   std::size_t count = 0;
+   std::vector<const Node*> stack;
+   stack.push_back(root.get());
+   while (stack.size() > 0) {
+      const Node* node = stack.back(); stack.pop_back();
+      ++count;
+      if (node->is_leaf()) continue;
+      for (std::size_t i = 0; i < node->size(); ++i) {
+	 stack.push_back(node->get_operand(i).get());
+      }
+   }
+   return count;
+}
+
 void CandidateSet::traverse(NodePtr& node, Context& context) const {
+   std::size_t index = next_index++;
    if (node->is_leaf()) return;
    Arity arity(node->size());
    Operator op = node->get_op();
@@ -74,24 +180,34 @@ void CandidateSet::traverse(NodePtr& node, Context& context) const {
    if (!suppress_conflicts || node != root) {
       for (RuleTable::iterator it = rules.find_prefix(op, Arity(), end);
 	    it != end; ++it) {
-	 found = add_matching_candidates(node, it->second, context);
+	 found = add_matching_candidates(node, index,
+	    it->second, context);
 	 if (found && suppress_conflicts) break;
       }
       if (!found || !suppress_conflicts) {
 	 for (RuleTable::iterator it = rules.find_prefix(op, arity, end);
 	       it != end; ++it) {
-	    found = add_matching_candidates(node, it->second, context);
+	    found = add_matching_candidates(node, index,
+	       it->second, context);
 	    if (found && suppress_conflicts) break;
 	 }
       }
    }
    // descending
    bool suppressed = suppress_conflicts && found;
+   if (suppressed && occurrence_locations) {
+      /* the nodes below are skipped */
+      next_index += count_nodes(node) - 1;
+   }
    if (!suppressed) {
       context.descend(node);
+      if (node->is_shared()) ++shared_ancestors;
       for (std::size_t i = 0; i < node->size(); ++i) {
+	 path.push_back(i);
 	 traverse(node->get_operand(i), context);
+	 path.pop_back();
       }
+      if (node->is_shared()) --shared_ancestors;
       // suppress the postfix visitation in case of transformations if
       //    - we consider the root or
       //    - a transformation would possibly conflict with another
@@ -107,33 +223,76 @@ void CandidateSet::traverse(NodePtr& node, Context& context) const {
       bool found = false; // matching rule found
       for (RuleTable::iterator it = rules.find_postfix(op, arity, end);
 	    it != end; ++it) {
-	 found = add_matching_candidates(node, it->second, context);
+	 found = add_matching_candidates(node, index,
+	    it->second, context);
 	 if (found && suppress_conflicts) break;
       }
       if (!found || !suppress_conflicts) {
 	 for (RuleTable::iterator it = rules.find_postfix(op, Arity(), end);
 	       it != end; ++it) {
-	    found = add_matching_candidates(node, it->second, context);
+	    found = add_matching_candidates(node, index,
+	       it->second, context);
 	    if (found && suppress_conflicts) break;
 	 }
       }
    }
 }
 
-bool CandidateSet::add_matching_candidates(NodePtr& node,
+bool CandidateSet::add_matching_candidates(NodePtr& node, std::size_t index,
       RulePtr rule, Context& context) const {
    auto local_bindings = std::make_shared<Bindings>(bindings);
-   auto left_expr = rule->get_tree_expression();
-   auto right_expr = rule->get_rhs();
-   if (matches(node, left_expr, local_bindings, context)) {
-      candidates.push_back(std::make_shared<Candidate>(root,
-	 node, rule, local_bindings));
+   if (memoized_matches(node, rule, local_bindings, context)) {
+      std::size_t slot;
+      if (keep_candidate(slot)) {
+	 CandidatePtr candidate;
+	 if (shared_ancestors > 0 || (node->is_shared() && !path.empty())) {
+	    /* the location of the shared node is that of
+	       its first occurrence */
+	    const Location& loc(occurrence_locations?
+	       occurrence_locations->get_location(index, *node):
+	       node->get_location());
+	    candidate = std::make_shared<Candidate>(root, node, path, loc,
+	       rule, local_bindings);
+	 } else {
+	    candidate = std::make_shared<Candidate>(root, node,
+	       rule, local_bindings);
+	 }
+	 if (slot == candidates.size()) {
+	    candidates.push_back(candidate);
+	 } else {
+	    candidates[slot] = candidate;
+	 }
+      }
       context.suppress_ancestors();
       return true;
    }
    return false;
 }
 
+/* a shared subtree is matched once per structural rule
+   as the bindings of the candidate set do not change while
+   traversing; later matches get clones of the bindings */
+bool CandidateSet::memoized_matches(const NodePtr& node,
+      const RulePtr& rule, BindingsPtr local_bindings,
+      Context& context) const {
+   auto tree_expr = rule->get_tree_expression();
+   if (!node->is_shared() || !rule->is_structural()) {
+      return matches(node, tree_expr, local_bindings, context);
+   }
+   MatchKey key(node.get(), rule.get());
+   auto it = match_results.find(key);
+   if (it != match_results.end()) {
+      return it->second && local_bindings->merge_clones(it->second);
+   }
+   BindingsPtr result;
+   if (matches(node, tree_expr, local_bindings, context)) {
+      result = std::make_shared<Bindings>();
+      result->merge_clones(local_bindings);
+   }
+   match_results[key] = result;
+   return result != nullptr;
+}
+
 std::size_t CandidateSet::size() const {
    generate();
    return candidates.size();
@@ -145,42 +304,94 @@ CandidatePtr CandidateSet::operator[](std::size_t index) const {
    return candidates[index];
 }
 
+/* pass the mutation of the given candidate to the consumer unless
+   duplicates are suppressed and an equal subtree has been put at
+   the same position before; returns false if the consumer asks
+   to stop */
+bool CandidateSet::consume(CandidatePtr candidate, std::size_t& consumed) {
+   NodePtr replacement;
+   NodePtr mutation = candidate->transform(replacement);
+   if (suppress_dups) {
+      const Node* root = candidate->get_root().get();
+      const NodePtr* subtree = candidate->get_subtree_ptr();
+      const std::vector<std::size_t>& path = candidate->get_path();
+      /* hash values serve as bucket keys only as they may collide */
+      std::size_t hashval = std::hash<const NodePtr*>()(subtree);
+      for (auto index: path) {
+	 hashval = hashval * 31 + index;
+      }
+      hashval = hashval * 31 + replacement->hash();
+      auto range = mutations.equal_range(hashval);
+      for (auto it = range.first; it != range.second; ++it) {
+	 const Mutation& m = it->second;
+	 if (m.root == root && m.subtree == subtree && m.path == path &&
+	       m.replacement->deep_tree_equality(replacement)) {
+	    ++duplicates;
+	    return true;
+	 }
+      }
+      /* the consumer is free to modify the mutation */
+      mutations.emplace(hashval,
+	 Mutation{root, subtree, path, clone(replacement)});
+   }
+   ++consumed;
+   return consumer->consume(mutation, candidate);
+}
+
 void CandidateSet::gen_mutation() {
-   generate();
-   assert(size() > 0); assert(consumer); assert(prg);
-   CandidatePtr candidate = candidates[prg->pick(size())];
-   consumer->consume(candidate->transform(), candidate);
+   assert(consumer); assert(prg);
+   CandidatePtr candidate;
+   if (generated) {
+      assert(size() > 0);
+      candidate = candidates[prg->pick(size())];
+   } else {
+      generate_sample(1);
+      assert(candidates.size() > 0);
+      candidate = candidates[0];
+      candidates.clear();
+   }
+   std::size_t consumed = 0;
+   consume(candidate, consumed);
 }
 
 void CandidateSet::gen_mutations() {
    generate();
    assert(consumer); assert(prg);
+   std::size_t consumed = 0;
    for (std::size_t i = 0; i < size(); ++i) {
-      CandidatePtr candidate = candidates[i];
-      consumer->consume(candidate->transform(), candidate);
+      consume(candidates[i], consumed);
    }
 }
 
-void CandidateSet::gen_mutations(std::size_t count) {
-   generate();
+std::size_t CandidateSet::gen_mutations(std::size_t count) {
    assert(consumer); assert(prg);
+   if (!generated) {
+      if (count == 0) return 0;
+      generate_sample(count);
+      std::vector<CandidatePtr> sample;
+      sample.swap(candidates);
+      std::size_t consumed = 0;
+      for (auto& candidate: sample) {
+	 if (!consume(candidate, consumed)) break;
+      }
+      return consumed;
+   }
    if (count > size()) count = size();
    /* select count candidates,
       see section 3.4.2 in Donald E. Knuth, TAOCP, Volume 2
    */
    std::size_t selected = 0; std::size_t seen = 0;
+   std::size_t consumed = 0;
    for (std::size_t i = 0; i < size(); ++i) {
       double rval = prg->val();
       if ((candidates.size() - seen) * rval < count - selected) {
-	 CandidatePtr candidate = candidates[i];
-	 if (!consumer->consume(candidate->transform(), candidate)) {
-	    return;
-	 }
 	 ++selected;
+	 if (!consume(candidates[i], consumed)) break;
 	 if (selected == count) break;
       }
       ++seen;
    }
+   return consumed;
 }
 
 CandidateSet& CandidateSet::operator+=(CandidatePtr candidate) {
@@ -194,6 +405,14 @@ void CandidateSet::suppress_transformation_conflicts() {
    suppress_conflicts = true;
 }
 
+void CandidateSet::suppress_duplicates() {
+   suppress_dups = true;
+}
+
+std::size_t CandidateSet::get_number_of_duplicates() const {
+   return duplicates;
+}
+
 void CandidateSet::set_consumer(ConsumerPtr consumer_param) {
    consumer = consumer_param;
 }
@@ -202,4 +421,9 @@ void CandidateSet::set_prg(PseudoRandomGeneratorPtr prg_param) {
    prg = prg_param;
 }
 
+void CandidateSet::set_occurrence_locations(
+      OccurrenceLocationsPtr locations) {
+   occurrence_locations = locations;
+}
+
 } // namespace Astl
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010, 2016 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2016, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -21,6 +21,8 @@
 
 #include <cstdlib>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <astl/bindings.hpp>
 #include <astl/candidate.hpp>
@@ -28,6 +30,7 @@
 #include <astl/exception.hpp>
 #include <astl/prg.hpp>
 #include <astl/rule-table.hpp>
+#include <astl/subtree-table.hpp>
 #include <astl/syntax-tree.hpp>
 
 namespace Astl {
@@ -52,19 +55,38 @@ namespace Astl {
 	 // accessors
 	 std::size_t size() const;
 	 CandidatePtr operator[](std::size_t index) const;
+	 /** number of mutations suppressed as duplicates so far */
+	 std::size_t get_number_of_duplicates() const;
 
 	 // generators
 	 // general PRE: consumer and prg must be well-defined */
+	 /*
+	    gen_mutation() and gen_mutations(count) do not materialize
+	    the full candidate set unless it has been generated before
+	    by one of the accessors; instead the candidates are sampled
+	    during the traversal such that at most count candidates
+	    (including their bindings) are kept at any time;
+	    gen_mutations(count) returns the number of mutations
+	    passed to the consumer
+	 */
 	 void gen_mutation();
 	 void gen_mutations();
-	 void gen_mutations(std::size_t count);
+	 std::size_t gen_mutations(std::size_t count);
 
 	 // mutators
 	 void set_consumer(ConsumerPtr consumer_param);
 	 void set_prg(PseudoRandomGeneratorPtr prg_param);
+	 void set_occurrence_locations(OccurrenceLocationsPtr locations);
+	    // locations of the occurrences of shared subtrees
+	    // as recorded by share_subtrees() for the root
 	 CandidateSet& operator+=(CandidatePtr candidate);
 	 void suppress_transformation_conflicts();
 	    // must not be invoked after using any of the accessors
+	 void suppress_duplicates();
+	    // mutations are not passed to the consumer if a
+	    // structurally equal subtree has been put at the same
+	    // position before; copies of the replacements are kept
+	    // for comparison
 
       private:
 	 mutable bool generated; // list of candidates generated?
@@ -75,10 +97,58 @@ namespace Astl {
 	 BindingsPtr bindings;
 	 ConsumerPtr consumer;
 	 PseudoRandomGeneratorPtr prg;
+	 /* state of the reservoir sampling while traversing */
+	 mutable std::size_t sample_size; // 0 if all candidates are kept
+	 mutable std::size_t seen; // number of candidates found so far
+	 mutable std::size_t next_pick; // next candidate to enter the reservoir
+	 mutable double weight;
+	 mutable std::vector<std::size_t> sample_index;
 	 void generate() const; // generate candidates, if necessary
+	 void generate_sample(std::size_t count) const;
+	 bool keep_candidate(std::size_t& slot) const;
+	 double random_weight() const;
+	 void skip_candidates() const;
+	 /* elimination of duplicate mutations */
+	 bool suppress_dups;
+	 /* mutations passed so far, identified by the position of
+	    the replaced subtree (see Candidate) and a copy of its
+	    replacement, by their hash values */
+	 struct Mutation {
+	    const Node* root;
+	    const NodePtr* subtree;
+	    std::vector<std::size_t> path;
+	    NodePtr replacement;
+	 };
+	 std::unordered_multimap<std::size_t, Mutation> mutations;
+	 std::size_t duplicates;
+	 bool consume(CandidatePtr candidate, std::size_t& consumed);
 	 void traverse(NodePtr& node, Context& context) const;
-	 bool add_matching_candidates(NodePtr& node,
+	 bool add_matching_candidates(NodePtr& node, std::size_t index,
 	    RulePtr rule, Context& context) const;
+	 /* match results of shared subtrees (see subtree-table.hpp)
+	    for structural rules while traversing; the bindings of
+	    the match are kept, nullptr if the rule did not match */
+	 using MatchKey = std::pair<const Node*, const Rule*>;
+	 struct MatchKeyHash {
+	    std::size_t operator()(const MatchKey& key) const {
+	       std::size_t h1 = std::hash<const Node*>()(key.first);
+	       std::size_t h2 = std::hash<const Rule*>()(key.second);
+	       return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+	    }
+	 };
+	 mutable std::unordered_map<MatchKey, BindingsPtr, MatchKeyHash>
+	    match_results;
+	 /* operand indices from the root to the visited node and
+	    the number of shared nodes among its ancestors; the path
+	    identifies candidates below shared nodes */
+	 mutable std::vector<std::size_t> path;
+	 mutable std::size_t shared_ancestors = 0;
+	 /* preorder index of the next node to be visited which
+	    identifies the occurrences of shared subtrees */
+	 mutable std::size_t next_index = 0;
+	 OccurrenceLocationsPtr occurrence_locations;
+	 bool memoized_matches(const NodePtr& node, const RulePtr& rule,
+	    BindingsPtr local_bindings, Context& context) const;
    };
 
 } // namespace Astl
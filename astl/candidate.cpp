@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2016 Andreas Franz Borchert
+   Copyright (C) 2009, 2016, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -32,10 +32,30 @@ namespace Astl {
 
 Candidate::Candidate(NodePtr root, NodePtr& node,
       RulePtr rule, BindingsPtr bindings) :
-      root(root), node(&node), bindings(bindings), rule(rule) {
+      root(root), node(&node), loc(node->get_location()),
+      bindings(bindings), rule(rule) {
+}
+
+Candidate::Candidate(NodePtr root, NodePtr& node,
+      const std::vector<std::size_t>& path,
+      RulePtr rule, BindingsPtr bindings) :
+      root(root), node(&node), path(path), loc(node->get_location()),
+      bindings(bindings), rule(rule) {
+}
+
+Candidate::Candidate(NodePtr root, NodePtr& node,
+      const std::vector<std::size_t>& path, const Location& loc,
+      RulePtr rule, BindingsPtr bindings) :
+      root(root), node(&node), path(path), loc(loc),
+      bindings(bindings), rule(rule) {
 }
 
 NodePtr Candidate::transform() const {
+   NodePtr replacement;
+   return transform(replacement);
+}
+
+NodePtr Candidate::transform(NodePtr& replacement) const {
    NodePtr rhs = rule->get_rhs();
    NodePtr pre_block; NodePtr post_block;
    if (!rhs->is_leaf() && rhs->get_op() == Op::transformation_instructions) {
@@ -54,10 +74,19 @@ NodePtr Candidate::transform() const {
    if (pre_block) execute(pre_block, bindings);
    NodePtr cloned_root;
    NodePtr* cloned_ptr = 0;
-   clone_tree_and_ptr(root, *node, cloned_root, cloned_ptr);
+   if (path.empty()) {
+      clone_tree_and_ptr(root, *node, cloned_root, cloned_ptr);
+   } else {
+      cloned_root = clone(root);
+      cloned_ptr = &cloned_root;
+      for (auto index: path) {
+	 cloned_ptr = &(*cloned_ptr)->get_operand(index);
+      }
+   }
    assert(cloned_ptr);
    *cloned_ptr = gen_tree(rhs);
    if (post_block) execute(post_block, bindings);
+   replacement = *cloned_ptr;
    // set "location" and "rulename" attribute
    AttributePtr rootAt = cloned_root->get_attribute();
    rootAt->update("location",
@@ -83,7 +112,27 @@ void Candidate::transform_inplace() const {
       rhs = rhs->get_operand(0);
    }
    if (pre_block) execute(pre_block, bindings);
-   *node = gen_tree(rhs);
+   if (path.empty()) {
+      *node = gen_tree(rhs);
+      Node::invalidate_hashes();
+   } else {
+      /* shared subtrees on the path from the root must not be
+	 modified, hence the path is copied from the first shared
+	 node on as the subnodes of a shared node are shared as well */
+      assert(!root->is_shared());
+      Node* parent = root.get();
+      bool below_shared = false;
+      for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+	 NodePtr subnode = parent->get_operand(path[i]);
+	 if (subnode->is_shared()) below_shared = true;
+	 if (below_shared) {
+	    subnode = std::make_shared<Node>(*subnode);
+	    parent->set_operand(path[i], subnode);
+	 }
+	 parent = subnode.get();
+      }
+      parent->set_operand(path.back(), gen_tree(rhs));
+   }
    if (post_block) execute(post_block, bindings);
 }
 
@@ -101,13 +150,25 @@ NodePtr Candidate::get_subtree() const {
 }
 
 const Location& Candidate::get_location() const {
-   return get_subtree()->get_location();
+   return loc;
 }
 
 BindingsPtr Candidate::get_bindings() const {
    return bindings;
 }
 
+NodePtr Candidate::get_root() const {
+   return root;
+}
+
+const NodePtr* Candidate::get_subtree_ptr() const {
+   return node;
+}
+
+const std::vector<std::size_t>& Candidate::get_path() const {
+   return path;
+}
+
 std::ostream& operator<<(std::ostream& out, CandidatePtr candidate) {
    return out << "rule " << candidate->get_rule() << " matches " <<
       candidate->get_subtree() << " with " << candidate->get_bindings() <<
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -21,6 +21,7 @@
 
 #include <iostream>
 #include <memory>
+#include <vector>
 #include <astl/bindings.hpp>
 #include <astl/exception.hpp>
 #include <astl/rule.hpp>
@@ -33,12 +34,28 @@ namespace Astl {
       public:
 	 Candidate(NodePtr root, NodePtr& node, RulePtr rule,
 	    BindingsPtr bindings);
+	 /* the path of operand indices from root to node is
+	    required if node is below a shared node as the
+	    subtree may occur multiple times within root */
+	 Candidate(NodePtr root, NodePtr& node,
+	    const std::vector<std::size_t>& path,
+	    RulePtr rule, BindingsPtr bindings);
+	 /* likewise for an occurrence of a shared subtree
+	    whose location differs from that of node */
+	 Candidate(NodePtr root, NodePtr& node,
+	    const std::vector<std::size_t>& path, const Location& loc,
+	    RulePtr rule, BindingsPtr bindings);
 
 	 // accessors
 	 RulePtr get_rule() const;
 	 NodePtr get_subtree() const;
 	 const Location& get_location() const;
 	 BindingsPtr get_bindings() const;
+	 /* the position of the matched subtree is identified
+	    by the root, the pointer to the subtree, and the path */
+	 NodePtr get_root() const;
+	 const NodePtr* get_subtree_ptr() const;
+	 const std::vector<std::size_t>& get_path() const;
 
 	 // transformations, in-place and cloning
 	 void transform_inplace() const;
@@ -46,10 +63,15 @@ namespace Astl {
 	 NodePtr transform() const;
 	    // clones the tree, executes the transformation on the
 	    // clone, and returns it
+	 NodePtr transform(NodePtr& replacement) const;
+	    // like transform() but the subtree which replaces the
+	    // matched subtree within the clone is returned as well
 
       private:
 	 const NodePtr root;
 	 NodePtr* node; // points to the matched subtree
+	 std::vector<std::size_t> path; // empty if node is unique
+	 Location loc; // location of this occurrence of node
 	 BindingsPtr bindings;
 	 const RulePtr rule; // matching rule
 	 NodePtr gen_tree(NodePtr root) const;
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -44,7 +44,7 @@ void gen_clone_tree_and_ptr(const NodePtr& root, const NodePtr& ptr,
 	    with_attributes);
       }
    }
-   if (with_attributes) {
+   if (with_attributes && root->has_attributes()) {
       AttributePtr attributes = root->get_attribute()->clone();
       cloned_root->set_attribute(attributes);
    }
@@ -0,0 +1,168 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cassert>
+#include <map>
+#include <memory>
+#include <astl/compiled-print-rule.hpp>
+#include <astl/operators.hpp>
+#include <astl/parser.hpp>
+#include <astl/syntax-tree.hpp>
+
+namespace Astl {
+
+// constructors =============================================================
+
+CompiledPrintRule::CompiledPrintRule(RulePtr rule, std::size_t id) :
+      rule(rule), id(id), leading(0), trailing(0), variable_length(false) {
+}
+
+CompiledPrintRulePtr CompiledPrintRule::compile(RulePtr rule,
+      std::size_t id) {
+   std::shared_ptr<CompiledPrintRule> crule(new CompiledPrintRule(rule, id));
+
+   /* analyze the tree expression */
+   NodePtr expr = rule->get_tree_expression();
+   if (expr->get_op() == Op::conditional_tree_expression ||
+	 expr->get_op() == Op::contextual_tree_expression) {
+      return nullptr;
+   }
+   std::map<std::string, Slot> slots;
+   std::string listvar;
+   if (expr->get_op() == Op::named_tree_expression) {
+      std::string name = expr->get_operand(1)->get_token().get_text();
+      slots[name] = Slot{Slot::root, 0};
+      expr = expr->get_operand(0);
+   }
+   NodePtr remaining_subnodes;
+   if (expr->get_op() == Op::variable_length_tree_expression) {
+      crule->variable_length = true;
+      if (expr->size() >= 2) {
+	 listvar = expr->get_operand(1)->get_token().get_text();
+	 if (expr->size() == 3) {
+	    remaining_subnodes = expr->get_operand(2);
+	 }
+      }
+      expr = expr->get_operand(0);
+   }
+   assert(expr->get_op() == Op::tree_expression);
+   crule->leading = expr->size() - 1;
+   if (remaining_subnodes) {
+      crule->trailing = remaining_subnodes->size();
+   }
+   auto bind = [&](const NodePtr& subnode, Slot slot) -> bool {
+      if (!subnode->is_leaf()) return false;
+      std::string name = subnode->get_token().get_text();
+      if (name == listvar || slots.find(name) != slots.end()) {
+	 /* repeated variables require a comparison */
+	 return false;
+      }
+      slots[name] = slot;
+      crule->variables.push_back(name);
+      return true;
+   };
+   for (std::size_t i = 0; i < crule->leading; ++i) {
+      if (!bind(expr->get_operand(i+1), Slot{Slot::leading, i})) {
+	 return nullptr;
+      }
+   }
+   for (std::size_t i = 0; i < crule->trailing; ++i) {
+      if (!bind(remaining_subnodes->get_operand(i),
+	    Slot{Slot::trailing, crule->trailing - i})) {
+	 return nullptr;
+      }
+   }
+   if (listvar.size() > 0) {
+      crule->variables.push_back(listvar);
+   }
+
+   /* translate the print expression */
+   NodePtr rhs = rule->get_rhs();
+   for (std::size_t i = 0; i < rhs->size(); ++i) {
+      const NodePtr& subnode = rhs->get_operand(i);
+      if (subnode->is_leaf()) {
+	 const Token& t = subnode->get_token();
+	 if (t.get_tokenval() == parser::token::TEXT_LITERAL) {
+	    crule->items.push_back(Item{Item::text, subnode, Slot()});
+	 } else {
+	    assert(t.get_tokenval() == parser::token::VARIABLE);
+	    auto it = slots.find(t.get_text());
+	    /* other variables are to be taken from outer scopes */
+	    if (it == slots.end()) return nullptr;
+	    crule->items.push_back(Item{Item::subtree, nullptr, it->second});
+	 }
+      } else if (subnode->get_op() == Op::print_expression_listvar) {
+	 std::string varname =
+	    subnode->get_operand(0)->get_token().get_text();
+	 if (listvar.size() == 0 || varname != listvar) return nullptr;
+	 NodePtr separator;
+	 if (subnode->size() == 2) {
+	    separator = subnode->get_operand(1);
+	 }
+	 crule->items.push_back(Item{Item::subtrees, separator, Slot()});
+      } else {
+	 /* expressions need bindings */
+	 return nullptr;
+      }
+   }
+   return crule;
+}
+
+// accessors ================================================================
+
+std::size_t CompiledPrintRule::get_id() const {
+   return id;
+}
+
+RulePtr CompiledPrintRule::get_rule() const {
+   return rule;
+}
+
+bool CompiledPrintRule::applicable(const NodePtr& node) const {
+   return !variable_length || node->size() >= leading + trailing;
+}
+
+const NodePtr& CompiledPrintRule::get_subtree(const NodePtr& node,
+      const Slot& slot) const {
+   switch (slot.kind) {
+      case Slot::leading:
+	 return node->get_operand(slot.index);
+      case Slot::trailing:
+	 return node->get_operand(node->size() - slot.index);
+      default:
+	 return node;
+   }
+}
+
+std::size_t CompiledPrintRule::get_list_begin() const {
+   return leading;
+}
+
+std::size_t CompiledPrintRule::get_list_end(const NodePtr& node) const {
+   return node->size() - trailing;
+}
+
+const CompiledPrintRule::Items& CompiledPrintRule::get_items() const {
+   return items;
+}
+
+const std::vector<std::string>& CompiledPrintRule::get_variables() const {
+   return variables;
+}
+
+} // namespace Astl
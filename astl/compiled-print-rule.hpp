@@ -0,0 +1,104 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_COMPILED_PRINT_RULE_H
+#define ASTL_COMPILED_PRINT_RULE_H
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <astl/rule.hpp>
+#include <astl/types.hpp>
+
+namespace Astl {
+
+   /**
+    * Most print rules are unconditional templates like
+    *
+    *    ("if" cond then_stmt else_stmt) -> q{...}
+    *
+    * which match every node with the given operator and arity
+    * and just bind their subtrees positionally. Such rules
+    * are recognized when the print rules are loaded and
+    * compiled into a sequence of items where each variable
+    * reference is replaced by the position of the subnode
+    * it refers to. This permits such rules to be
+    * applied without creating any bindings.
+    *
+    * Rules with conditions, contexts, nested tree expressions,
+    * regular expressions, string literals, repeated variables,
+    * or expressions within the print expression are not compiled.
+    */
+   class CompiledPrintRule {
+      public:
+	 /** subnode reference of a compiled print rule */
+	 struct Slot {
+	    using Kind = enum {root, leading, trailing};
+	    Kind kind;
+	    std::size_t index;
+	 };
+	 struct Item {
+	    using Kind = enum {text, subtree, subtrees};
+	    Kind kind;
+	    NodePtr literal; // text literal or list separator, if any
+	    Slot slot; // for subtree
+	 };
+	 using Items = std::vector<Item>;
+
+	 /**
+	  * Return the compiled form of the given print rule
+	  * or nullptr if the rule is not suitable for compilation.
+	  */
+	 static std::shared_ptr<CompiledPrintRule> compile(RulePtr rule,
+	    std::size_t id);
+
+	 // accessors
+	 std::size_t get_id() const;
+	 RulePtr get_rule() const;
+	 /** check the number of subnodes of variable-length rules */
+	 bool applicable(const NodePtr& node) const;
+	 const NodePtr& get_subtree(const NodePtr& node,
+	    const Slot& slot) const;
+	 /** first and last position + 1 of the subnodes bound to a list */
+	 std::size_t get_list_begin() const;
+	 std::size_t get_list_end(const NodePtr& node) const;
+	 const Items& get_items() const;
+	 /**
+	  * Variables whose binding would be changed into a comparison
+	  * if they are already defined in an outer scope.
+	  */
+	 const std::vector<std::string>& get_variables() const;
+
+      private:
+	 CompiledPrintRule(RulePtr rule, std::size_t id);
+
+	 RulePtr rule;
+	 std::size_t id; // index within the print rule table
+	 std::size_t leading; // number of leading fixed-position subnodes
+	 std::size_t trailing; // fixed-position subnodes following a list
+	 bool variable_length;
+	 Items items;
+	 std::vector<std::string> variables;
+   };
+
+   using CompiledPrintRulePtr = std::shared_ptr<CompiledPrintRule>;
+
+} // namespace Astl
+
+#endif
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2019 Andreas Franz Borchert
+   Copyright (C) 2009-2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -47,9 +47,53 @@ AttributePtr create_environment() {
    return dict;
 }
 
+/*
+   create the outermost scope which does not depend on a particular
+   run and is shared by all default bindings of this process
+*/
+static BindingsPtr create_shared_bindings() {
+   auto bindings = std::make_shared<Bindings>();
+
+   // add "true" and "false"
+   bindings->define("true", std::make_shared<Attribute>(true));
+   bindings->define("false", std::make_shared<Attribute>(false));
+
+   // add standard streams "stdin", "stdout" and "stderr"
+   bindings->define("stdin",
+      std::make_shared<Attribute>(std::make_shared<InputStream>(std::cin,
+	 "stdin")));
+   bindings->define("stdout",
+      std::make_shared<Attribute>(std::make_shared<OutputStream>(std::cout,
+         "stdout")));
+   bindings->define("stderr",
+      std::make_shared<Attribute>(std::make_shared<OutputStream>(std::cerr,
+	 "stderr")));
+
+   // add standard functions which do not depend on a run
+   BuiltinFunctions bfs;
+   insert_shared_std_functions(bfs);
+   bfs.insert(bindings);
+
+   bindings->mk_all_const();
+   bindings->mk_immutable();
+   return bindings;
+}
+
+static BindingsPtr get_shared_bindings() {
+   static BindingsPtr bindings = create_shared_bindings();
+   return bindings;
+}
+
+/* global names must not hide any of the shared bindings */
+static bool define_global(BindingsPtr bindings, const std::string& name,
+      FunctionPtr f) {
+   if (bindings->defined(name)) return false;
+   return bindings->define(name, std::make_shared<Attribute>(f));
+}
+
 BindingsPtr create_default_bindings(NodePtr root,
       const Rules* rulesp, BindingsPtr extra_bindings) {
-   auto bindings = std::make_shared<Bindings>(rulesp);
+   auto bindings = std::make_shared<Bindings>(get_shared_bindings(), rulesp);
    // add "root" and "graph"
    if (root) {
       bindings->define("root", std::make_shared<Attribute>(root));
@@ -66,27 +110,12 @@ BindingsPtr create_default_bindings(NodePtr root,
       bindings = std::make_shared<Bindings>(bindings);
       bindings->define("graph", std::make_shared<Attribute>());
    }
-   // add "true" and "false"
-   bindings->define("true", std::make_shared<Attribute>(true));
-   bindings->define("false", std::make_shared<Attribute>(false));
-
-   // add standard streams "stdin", "stdout" and "stderr"
-   bindings->define("stdin",
-      std::make_shared<Attribute>(std::make_shared<InputStream>(std::cin,
-	 "stdin")));
-   bindings->define("stdout",
-      std::make_shared<Attribute>(std::make_shared<OutputStream>(std::cout,
-         "stdout")));
-   bindings->define("stderr",
-      std::make_shared<Attribute>(std::make_shared<OutputStream>(std::cerr,
-	 "stderr")));
-
-   // add "env" as dictionary of environment variables
+   // add "env" as dictionary of environment variables;
+   // each run gets its own as dictionaries are mutable
    bindings->define("env", create_environment());
-
-   // add standard functions to bindings
+   // add the standard functions which depend on this run
    BuiltinFunctions bfs;
-   insert_std_functions(bfs);
+   insert_local_std_functions(bfs);
    bfs.insert(bindings);
 
    // add extra bindings, if any (usually standard functions of extensions
@@ -110,7 +139,7 @@ BindingsPtr create_default_bindings(NodePtr root,
 	    auto block = fnode->get_operand(2);
 	    f = std::make_shared<RegularFunction>(block, bindings, params);
 	 }
-	 if (!bindings->define(it->first, std::make_shared<Attribute>(f))) {
+	 if (!define_global(bindings, it->first, f)) {
 	    throw Exception(it->second->get_location(),
 	       "multiply defined: " + it->first);
 	 }
@@ -122,7 +151,7 @@ BindingsPtr create_default_bindings(NodePtr root,
 	 FunctionPtr f =
 	    std::make_shared<TransformationRuleSetFunction>(it->second,
 	       bindings);
-	 if (!bindings->define(it->first, std::make_shared<Attribute>(f))) {
+	 if (!define_global(bindings, it->first, f)) {
 	    throw Exception("multiply defined: " + it->first);
 	 }
       }
@@ -132,7 +161,7 @@ BindingsPtr create_default_bindings(NodePtr root,
 	    it != niptrtab.end(); ++it) {
 	 FunctionPtr f = std::make_shared<InplaceTransformationRuleSetFunction>(
 	    it->second, bindings);
-	 if (!bindings->define(it->first, std::make_shared<Attribute>(f))) {
+	 if (!define_global(bindings, it->first, f)) {
 	    throw Exception("multiply defined: " + it->first);
 	 }
       }
@@ -142,7 +171,7 @@ BindingsPtr create_default_bindings(NodePtr root,
 	    it != nrtab.end(); ++it) {
 	 FunctionPtr f =
 	    std::make_shared<AttributionRuleSetFunction>(it->second, bindings);
-	 if (!bindings->define(it->first, std::make_shared<Attribute>(f))) {
+	 if (!define_global(bindings, it->first, f)) {
 	    throw Exception("multiply defined: " + it->first);
 	 }
       }
@@ -152,7 +181,7 @@ BindingsPtr create_default_bindings(NodePtr root,
 	    it != nrptab.end(); ++it) {
 	 FunctionPtr f =
 	    std::make_shared<PrintRuleSetFunction>(it->second, bindings);
-	 if (!bindings->define(it->first, std::make_shared<Attribute>(f))) {
+	 if (!define_global(bindings, it->first, f)) {
 	    throw Exception("multiply defined: " + it->first);
 	 }
       }
@@ -0,0 +1,560 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <utility>
+#include <astl/flow-graph-analysis.hpp>
+
+namespace Astl {
+
+static constexpr std::size_t npos = ~std::size_t(0);
+
+typedef std::vector<std::size_t> Indices;
+
+/* indices of all nodes reachable from root in reverse postorder */
+static void index_rpo(const std::vector<Indices>& successors,
+      std::size_t root, Indices& order) {
+   order.clear();
+   typedef std::pair<std::size_t, std::size_t> Frame;
+   std::vector<Frame> stack;
+   std::vector<bool> visited(successors.size());
+   visited[root] = true;
+   stack.push_back(Frame(root, 0));
+   while (stack.size() > 0) {
+      Frame& frame = stack.back();
+      const Indices& succ = successors[frame.first];
+      if (frame.second == succ.size()) {
+	 order.push_back(frame.first);
+	 stack.pop_back();
+      } else {
+	 std::size_t next = succ[frame.second++];
+	 if (!visited[next]) {
+	    visited[next] = true;
+	    stack.push_back(Frame(next, 0));
+	 }
+      }
+   }
+   std::reverse(order.begin(), order.end());
+}
+
+/*
+   iterative algorithm by Cooper, Harvey, and Kennedy,
+   "A Simple, Fast Dominance Algorithm", 2001;
+   order lists the reachable nodes in reverse postorder
+   beginning with the root, idom is set to npos for the root
+   and all unreachable nodes
+*/
+static void compute_idoms(const std::vector<Indices>& predecessors,
+      const Indices& order, Indices& idom) {
+   std::size_t size = predecessors.size();
+   Indices rpo(size, npos);
+   for (std::size_t i = 0; i < order.size(); ++i) {
+      rpo[order[i]] = i;
+   }
+   idom.assign(size, npos);
+   if (order.size() == 0) return;
+   std::size_t root = order[0];
+   idom[root] = root;
+   auto intersect = [&](std::size_t b1, std::size_t b2) {
+      while (b1 != b2) {
+	 while (rpo[b1] > rpo[b2]) b1 = idom[b1];
+	 while (rpo[b2] > rpo[b1]) b2 = idom[b2];
+      }
+      return b1;
+   };
+   bool changed = true;
+   while (changed) {
+      changed = false;
+      for (std::size_t i = 1; i < order.size(); ++i) {
+	 std::size_t b = order[i];
+	 std::size_t new_idom = npos;
+	 for (auto p: predecessors[b]) {
+	    if (idom[p] == npos) continue; // not processed yet
+	    if (new_idom == npos) {
+	       new_idom = p;
+	    } else {
+	       new_idom = intersect(p, new_idom);
+	    }
+	 }
+	 if (idom[b] != new_idom) {
+	    idom[b] = new_idom; changed = true;
+	 }
+      }
+   }
+   idom[root] = npos;
+}
+
+// constructor ==============================================================
+
+FlowGraphAnalysis::FlowGraphAnalysis(FlowGraphNodePtr entry) {
+   assert(entry);
+   std::vector<FlowGraphNodePtr> order;
+   reverse_postorder(entry, order);
+   std::size_t size = order.size();
+   nodes.reserve(size);
+   for (std::size_t i = 0; i < size; ++i) {
+      nodes.push_back(order[i]);
+      index[order[i].get()] = i;
+   }
+   successors.resize(size);
+   predecessors.resize(size);
+   for (std::size_t i = 0; i < size; ++i) {
+      for (auto it = order[i]->begin_links();
+	    it != order[i]->end_links(); ++it) {
+	 std::size_t j = index[it->node.get()];
+	 successors[i].push_back(j);
+	 predecessors[j].push_back(i);
+      }
+   }
+   compute_dominators();
+   compute_postdominators();
+   compute_frontiers();
+   compute_loops();
+   compute_components();
+}
+
+// cache ====================================================================
+
+namespace {
+   struct CacheEntry {
+      std::weak_ptr<FlowGraphNode> entry;
+      FlowGraphAnalysisPtr analysis;
+   };
+}
+
+static std::mutex cache_mutex;
+static std::size_t cache_generation = 0;
+static std::unordered_map<const FlowGraphNode*, CacheEntry> cache;
+
+FlowGraphAnalysisPtr FlowGraphAnalysis::get(FlowGraphNodePtr entry) {
+   assert(entry);
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   std::size_t generation = flow_graph_generation();
+   if (generation != cache_generation) {
+      cache.clear(); cache_generation = generation;
+   }
+   auto it = cache.find(entry.get());
+   if (it != cache.end() && !it->second.entry.expired()) {
+      return it->second.analysis;
+   }
+   /* drop the analyses of graphs which are no longer in use */
+   for (auto it = cache.begin(); it != cache.end();) {
+      if (it->second.entry.expired()) {
+	 it = cache.erase(it);
+      } else {
+	 ++it;
+      }
+   }
+   auto analysis = std::make_shared<const FlowGraphAnalysis>(entry);
+   cache[entry.get()] = CacheEntry{entry, analysis};
+   return analysis;
+}
+
+// accessors ================================================================
+
+bool FlowGraphAnalysis::reachable(const FlowGraphNodePtr& node) const {
+   return lookup(node) != npos;
+}
+
+FlowGraphNodePtr FlowGraphAnalysis::get_idom(
+      const FlowGraphNodePtr& node) const {
+   std::size_t i = lookup(node);
+   if (i == npos) return nullptr;
+   return node_at(dom.parent[i]);
+}
+
+bool FlowGraphAnalysis::dominates(const FlowGraphNodePtr& node1,
+      const FlowGraphNodePtr& node2) const {
+   std::size_t i1 = lookup(node1); std::size_t i2 = lookup(node2);
+   if (i1 == npos || i2 == npos) return false;
+   return ancestor(dom, i1, i2);
+}
+
+FlowGraphNodePtr FlowGraphAnalysis::get_ipdom(
+      const FlowGraphNodePtr& node) const {
+   std::size_t i = lookup(node);
+   if (i == npos) return nullptr;
+   return node_at(pdom.parent[i]);
+}
+
+bool FlowGraphAnalysis::postdominates(const FlowGraphNodePtr& node1,
+      const FlowGraphNodePtr& node2) const {
+   std::size_t i1 = lookup(node1); std::size_t i2 = lookup(node2);
+   if (i1 == npos || i2 == npos) return false;
+   return ancestor(pdom, i1, i2);
+}
+
+void FlowGraphAnalysis::get_frontier(const FlowGraphNodePtr& node,
+      std::vector<FlowGraphNodePtr>& frontier) const {
+   frontier.clear();
+   std::size_t i = lookup(node);
+   if (i == npos) return;
+   for (auto j: frontiers[i]) {
+      frontier.push_back(node_at(j));
+   }
+}
+
+FlowGraphNodePtr FlowGraphAnalysis::get_loop_header(
+      const FlowGraphNodePtr& node) const {
+   std::size_t i = lookup(node);
+   if (i == npos) return nullptr;
+   return node_at(loop_header[i]);
+}
+
+FlowGraphNodePtr FlowGraphAnalysis::get_loop_parent(
+      const FlowGraphNodePtr& header) const {
+   std::size_t i = lookup(header);
+   if (i == npos || loop_header[i] != i) return nullptr;
+   return node_at(loop_parent[i]);
+}
+
+std::size_t FlowGraphAnalysis::get_loop_depth(
+      const FlowGraphNodePtr& node) const {
+   std::size_t i = lookup(node);
+   if (i == npos || loop_header[i] == npos) return 0;
+   return loop_depth[loop_header[i]];
+}
+
+std::size_t FlowGraphAnalysis::get_number_of_components() const {
+   return components.size();
+}
+
+bool FlowGraphAnalysis::get_component(const FlowGraphNodePtr& node,
+      std::size_t& comp) const {
+   std::size_t i = lookup(node);
+   if (i == npos) return false;
+   comp = component[i];
+   return true;
+}
+
+void FlowGraphAnalysis::get_component_nodes(std::size_t comp,
+      std::vector<FlowGraphNodePtr>& members) const {
+   members.clear();
+   if (comp >= components.size()) return;
+   for (auto i: components[comp]) {
+      members.push_back(node_at(i));
+   }
+}
+
+bool FlowGraphAnalysis::reaches(const FlowGraphNodePtr& node1,
+      const FlowGraphNodePtr& node2) const {
+   std::size_t i1 = lookup(node1); std::size_t i2 = lookup(node2);
+   if (i1 == npos || i2 == npos) return false;
+   if (i1 == i2) return true;
+   std::call_once(closure_flag, [this]() { compute_closure(); });
+   if (closure.size() > 0) {
+      return closure[component[i1]].test(component[i2]);
+   }
+   NodeSet visited(nodes.size());
+   search(i1, nullptr, visited);
+   return visited.test(i2);
+}
+
+bool FlowGraphAnalysis::reaches(const FlowGraphNodePtr& node1,
+      const FlowGraphNodePtr& node2,
+      const std::vector<FlowGraphNodePtr>& avoid) const {
+   if (avoid.size() == 0) return reaches(node1, node2);
+   std::size_t i1 = lookup(node1); std::size_t i2 = lookup(node2);
+   if (i1 == npos || i2 == npos) return false;
+   if (i1 == i2) return true;
+   NodeSet avoidset;
+   avoidance_set(avoid, avoidset);
+   if (avoidset.test(i2)) return false;
+   NodeSet visited(nodes.size());
+   search(i1, &avoidset, visited);
+   return visited.test(i2);
+}
+
+void FlowGraphAnalysis::get_reachable(const FlowGraphNodePtr& node,
+      const std::vector<FlowGraphNodePtr>& avoid,
+      std::vector<FlowGraphNodePtr>& reachable) const {
+   reachable.clear();
+   std::size_t start = lookup(node);
+   if (start == npos) return;
+   NodeSet visited(nodes.size());
+   if (avoid.size() > 0) {
+      NodeSet avoidset;
+      avoidance_set(avoid, avoidset);
+      search(start, &avoidset, visited);
+   } else {
+      search(start, nullptr, visited);
+   }
+   for (std::size_t i = visited.find_first(); i != NodeSet::npos;
+	 i = visited.find_next(i)) {
+      reachable.push_back(node_at(i));
+   }
+}
+
+// private methods ==========================================================
+
+std::size_t FlowGraphAnalysis::lookup(const FlowGraphNodePtr& node) const {
+   if (!node) return npos;
+   auto it = index.find(node.get());
+   if (it == index.end()) return npos;
+   return it->second;
+}
+
+FlowGraphNodePtr FlowGraphAnalysis::node_at(std::size_t i) const {
+   if (i >= nodes.size()) return nullptr;
+   return nodes[i].lock();
+}
+
+void FlowGraphAnalysis::compute_dominators() {
+   /* the nodes are already in reverse postorder */
+   Indices order(nodes.size());
+   for (std::size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+   }
+   compute_idoms(predecessors, order, dom.parent);
+   number_tree(dom, 0);
+}
+
+void FlowGraphAnalysis::compute_postdominators() {
+   /* reversed graph with a virtual exit node at index size */
+   std::size_t size = nodes.size();
+   std::vector<Indices> rsuccessors(predecessors);
+   std::vector<Indices> rpredecessors(successors);
+   rsuccessors.emplace_back();
+   rpredecessors.emplace_back();
+   for (std::size_t i = 0; i < size; ++i) {
+      if (successors[i].size() == 0) {
+	 rsuccessors[size].push_back(i);
+	 rpredecessors[i].push_back(size);
+      }
+   }
+   Indices order;
+   index_rpo(rsuccessors, size, order);
+   compute_idoms(rpredecessors, order, pdom.parent);
+   number_tree(pdom, size);
+   for (auto& parent: pdom.parent) {
+      if (parent == size) parent = npos;
+   }
+   pdom.parent.resize(size);
+}
+
+void FlowGraphAnalysis::compute_frontiers() {
+   /* see Cooper, Harvey, and Kennedy, figure 5;
+      the entry node at index 0 has an additional virtual
+      predecessor which precedes the flow graph */
+   std::size_t size = nodes.size();
+   frontiers.assign(size, Indices());
+   for (std::size_t b = 0; b < size; ++b) {
+      std::size_t nofpredecessors = predecessors[b].size();
+      if (b == 0) ++nofpredecessors;
+      if (nofpredecessors < 2) continue;
+      for (auto p: predecessors[b]) {
+	 std::size_t runner = p;
+	 while (runner != npos && runner != dom.parent[b]) {
+	    Indices& frontier = frontiers[runner];
+	    if (frontier.size() > 0 && frontier.back() == b) break;
+	    frontier.push_back(b);
+	    runner = dom.parent[runner];
+	 }
+      }
+   }
+}
+
+void FlowGraphAnalysis::compute_loops() {
+   std::size_t size = nodes.size();
+   loop_header.assign(size, npos);
+   loop_parent.assign(size, npos);
+   loop_depth.assign(size, 0);
+   std::vector<Indices> back_edges(size);
+   for (std::size_t t = 0; t < size; ++t) {
+      for (auto h: successors[t]) {
+	 if (ancestor(dom, h, t)) back_edges[h].push_back(t);
+      }
+   }
+   auto outermost = [&](std::size_t v) {
+      std::size_t h = loop_header[v];
+      if (h == npos) return v;
+      while (loop_parent[h] != npos) h = loop_parent[h];
+      return h;
+   };
+   /* inner loops have headers later in reverse postorder
+      than the loops enclosing them and are collapsed
+      into their headers when the outer loop is collected */
+   Indices mark(size, npos);
+   Indices stack;
+   for (std::size_t h = size; h-- > 0;) {
+      if (back_edges[h].size() == 0) continue;
+      loop_header[h] = h; mark[h] = h;
+      stack = back_edges[h];
+      while (stack.size() > 0) {
+	 std::size_t u = outermost(stack.back()); stack.pop_back();
+	 if (mark[u] == h) continue;
+	 mark[u] = h;
+	 if (loop_header[u] == npos) {
+	    loop_header[u] = h;
+	 } else {
+	    loop_parent[u] = h;
+	 }
+	 stack.insert(stack.end(),
+	    predecessors[u].begin(), predecessors[u].end());
+      }
+   }
+   /* enclosing headers dominate and therefore precede their inner ones */
+   for (std::size_t h = 0; h < size; ++h) {
+      if (loop_header[h] != h) continue;
+      if (loop_parent[h] == npos) {
+	 loop_depth[h] = 1;
+      } else {
+	 loop_depth[h] = loop_depth[loop_parent[h]] + 1;
+      }
+   }
+}
+
+void FlowGraphAnalysis::compute_components() {
+   /* iterative version of Tarjan's algorithm which delivers
+      the components in reverse topological order */
+   std::size_t size = nodes.size();
+   component.assign(size, npos);
+   components.clear();
+   Indices number(size, npos);
+   Indices lowlink(size);
+   Indices stack;
+   std::vector<bool> on_stack(size);
+   typedef std::pair<std::size_t, std::size_t> Frame;
+   std::vector<Frame> frames;
+   std::size_t next_number = 0;
+   auto visit = [&](std::size_t v) {
+      number[v] = lowlink[v] = next_number++;
+      stack.push_back(v); on_stack[v] = true;
+      frames.push_back(Frame(v, 0));
+   };
+   for (std::size_t root = 0; root < size; ++root) {
+      if (number[root] != npos) continue;
+      visit(root);
+      while (frames.size() > 0) {
+	 Frame& frame = frames.back();
+	 std::size_t v = frame.first;
+	 if (frame.second < successors[v].size()) {
+	    std::size_t w = successors[v][frame.second++];
+	    if (number[w] == npos) {
+	       visit(w);
+	    } else if (on_stack[w] && number[w] < lowlink[v]) {
+	       lowlink[v] = number[w];
+	    }
+	    continue;
+	 }
+	 frames.pop_back();
+	 if (frames.size() > 0) {
+	    std::size_t u = frames.back().first;
+	    if (lowlink[v] < lowlink[u]) lowlink[u] = lowlink[v];
+	 }
+	 if (lowlink[v] == number[v]) {
+	    Indices members;
+	    std::size_t w;
+	    do {
+	       w = stack.back(); stack.pop_back(); on_stack[w] = false;
+	       members.push_back(w);
+	    } while (w != v);
+	    /* keep the members in reverse postorder */
+	    std::sort(members.begin(), members.end());
+	    components.push_back(std::move(members));
+	 }
+      }
+   }
+   std::reverse(components.begin(), components.end());
+   for (std::size_t c = 0; c < components.size(); ++c) {
+      for (auto i: components[c]) {
+	 component[i] = c;
+      }
+   }
+}
+
+/* the closure requires a quadratic number of bits */
+static constexpr std::size_t max_closure_components = 1<<14;
+
+void FlowGraphAnalysis::compute_closure() const {
+   std::size_t count = components.size();
+   if (count > max_closure_components) return;
+   closure.assign(count, NodeSet(count));
+   /* successors of a component are later in topological order */
+   for (std::size_t c = count; c-- > 0;) {
+      NodeSet& reach = closure[c];
+      reach.set(c);
+      for (auto i: components[c]) {
+	 for (auto j: successors[i]) {
+	    std::size_t d = component[j];
+	    if (d != c && !reach.test(d)) reach |= closure[d];
+	 }
+      }
+   }
+}
+
+void FlowGraphAnalysis::search(std::size_t start, const NodeSet* avoid,
+      NodeSet& visited) const {
+   Indices stack;
+   visited.set(start);
+   stack.push_back(start);
+   while (stack.size() > 0) {
+      std::size_t v = stack.back(); stack.pop_back();
+      for (auto w: successors[v]) {
+	 if (visited.test(w) || (avoid && avoid->test(w))) continue;
+	 visited.set(w);
+	 stack.push_back(w);
+      }
+   }
+}
+
+void FlowGraphAnalysis::avoidance_set(
+      const std::vector<FlowGraphNodePtr>& avoid, NodeSet& set) const {
+   set.resize(nodes.size());
+   for (auto& node: avoid) {
+      std::size_t i = lookup(node);
+      if (i != npos) set.set(i);
+   }
+}
+
+void FlowGraphAnalysis::number_tree(Tree& tree, std::size_t root) {
+   std::size_t size = tree.parent.size();
+   std::vector<Indices> children(size);
+   for (std::size_t i = 0; i < size; ++i) {
+      if (tree.parent[i] != npos) children[tree.parent[i]].push_back(i);
+   }
+   tree.pre.assign(size, npos);
+   tree.post.assign(size, npos);
+   if (root >= size) return;
+   std::size_t prenum = 0; std::size_t postnum = 0;
+   typedef std::pair<std::size_t, std::size_t> Frame;
+   std::vector<Frame> stack;
+   tree.pre[root] = prenum++;
+   stack.push_back(Frame(root, 0));
+   while (stack.size() > 0) {
+      Frame& frame = stack.back();
+      if (frame.second == children[frame.first].size()) {
+	 tree.post[frame.first] = postnum++;
+	 stack.pop_back();
+      } else {
+	 std::size_t child = children[frame.first][frame.second++];
+	 tree.pre[child] = prenum++;
+	 stack.push_back(Frame(child, 0));
+      }
+   }
+}
+
+bool FlowGraphAnalysis::ancestor(const Tree& tree,
+      std::size_t i1, std::size_t i2) {
+   if (tree.pre[i1] == npos || tree.pre[i2] == npos) return false;
+   return tree.pre[i1] <= tree.pre[i2] && tree.post[i2] <= tree.post[i1];
+}
+
+} // namespace Astl
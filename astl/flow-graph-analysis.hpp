@@ -0,0 +1,153 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_FLOW_GRAPH_ANALYSIS_H
+#define ASTL_FLOW_GRAPH_ANALYSIS_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <astl/flow-graph.hpp>
+#include <astl/types.hpp>
+
+namespace Astl {
+
+   class FlowGraphAnalysis;
+   typedef std::shared_ptr<const FlowGraphAnalysis> FlowGraphAnalysisPtr;
+
+   /**
+    * Dominators, post-dominators, dominance frontiers, and
+    * the nesting forest of natural loops of all nodes
+    * reachable from an entry node.
+    *
+    * Dominators are computed using the iterative algorithm by
+    * Cooper, Harvey, and Kennedy over the reverse postorder.
+    * Post-dominators are computed in the same way on the
+    * reversed graph where all nodes without outgoing links
+    * are connected to a virtual exit node. Nodes which do
+    * not reach any exit have no post-dominators.
+    *
+    * Loops are the natural loops of back edges, i.e. of links
+    * whose target dominates its source. Retreating edges of
+    * irreducible cycles do not constitute loops.
+    *
+    * Reachability queries are answered by the transitive closure
+    * of the condensation into strongly connected components which
+    * is computed on the first query, provided the number of
+    * components is not too large. Otherwise and in case of
+    * nodes to be avoided, the graph is searched for each query.
+    *
+    * Analyses are cached per entry node and invalidated
+    * as soon as a link is added to any flow graph.
+    */
+   class FlowGraphAnalysis {
+      public:
+	 FlowGraphAnalysis(FlowGraphNodePtr entry);
+
+	 /** return the cached analysis for the given entry node */
+	 static FlowGraphAnalysisPtr get(FlowGraphNodePtr entry);
+
+	 // accessors
+	 bool reachable(const FlowGraphNodePtr& node) const;
+	 /* nullptr for the entry and unreachable nodes */
+	 FlowGraphNodePtr get_idom(const FlowGraphNodePtr& node) const;
+	 bool dominates(const FlowGraphNodePtr& node1,
+	    const FlowGraphNodePtr& node2) const;
+	 /* nullptr if the node is immediately post-dominated
+	    by the virtual exit node */
+	 FlowGraphNodePtr get_ipdom(const FlowGraphNodePtr& node) const;
+	 bool postdominates(const FlowGraphNodePtr& node1,
+	    const FlowGraphNodePtr& node2) const;
+	 void get_frontier(const FlowGraphNodePtr& node,
+	    std::vector<FlowGraphNodePtr>& frontier) const;
+	 /* header of the innermost loop containing the node;
+	    a loop header belongs to its own loop */
+	 FlowGraphNodePtr get_loop_header(const FlowGraphNodePtr& node) const;
+	 /* header of the loop enclosing the loop of the given header */
+	 FlowGraphNodePtr get_loop_parent(const FlowGraphNodePtr& header) const;
+	 std::size_t get_loop_depth(const FlowGraphNodePtr& node) const;
+	 /* strongly connected components in topological order */
+	 std::size_t get_number_of_components() const;
+	 /* returns false for unreachable nodes */
+	 bool get_component(const FlowGraphNodePtr& node,
+	    std::size_t& component) const;
+	 void get_component_nodes(std::size_t component,
+	    std::vector<FlowGraphNodePtr>& members) const;
+	 /* node2 is reachable from node1 by a path of length >= 0
+	    that does not pass any of the nodes to be avoided
+	    except possibly node1 */
+	 bool reaches(const FlowGraphNodePtr& node1,
+	    const FlowGraphNodePtr& node2) const;
+	 bool reaches(const FlowGraphNodePtr& node1,
+	    const FlowGraphNodePtr& node2,
+	    const std::vector<FlowGraphNodePtr>& avoid) const;
+	 /* all nodes reachable from node in reverse postorder */
+	 void get_reachable(const FlowGraphNodePtr& node,
+	    const std::vector<FlowGraphNodePtr>& avoid,
+	    std::vector<FlowGraphNodePtr>& reachable) const;
+
+      private:
+	 typedef std::vector<std::size_t> Indices;
+	 typedef boost::dynamic_bitset<unsigned long> NodeSet;
+	 struct Tree {
+	    Indices parent; // npos for the root and unreached nodes
+	    /* preorder and postorder numbers of a depth-first
+	       traversal for constant-time ancestor queries */
+	    Indices pre;
+	    Indices post;
+	 };
+
+	 /* reachable nodes in reverse postorder; the analysis
+	    refers to them weakly as they are kept alive by the entry */
+	 std::vector<std::weak_ptr<FlowGraphNode>> nodes;
+	 std::unordered_map<const FlowGraphNode*, std::size_t> index;
+	 std::vector<Indices> predecessors;
+	 std::vector<Indices> successors;
+	 Tree dom;
+	 Tree pdom;
+	 std::vector<Indices> frontiers;
+	 Indices loop_header; // innermost header, npos if none
+	 Indices loop_parent; // for headers only
+	 Indices loop_depth; // for headers only
+	 Indices component; // by node
+	 std::vector<Indices> components; // nodes by component
+	 /* transitive closure of the condensation, computed on demand */
+	 mutable std::once_flag closure_flag;
+	 mutable std::vector<NodeSet> closure;
+
+	 std::size_t lookup(const FlowGraphNodePtr& node) const;
+	 FlowGraphNodePtr node_at(std::size_t i) const;
+	 void compute_dominators();
+	 void compute_postdominators();
+	 void compute_frontiers();
+	 void compute_loops();
+	 void compute_components();
+	 void compute_closure() const;
+	 void search(std::size_t start, const NodeSet* avoid,
+	    NodeSet& visited) const;
+	 void avoidance_set(const std::vector<FlowGraphNodePtr>& avoid,
+	    NodeSet& set) const;
+	 static void number_tree(Tree& tree, std::size_t root);
+	 static bool ancestor(const Tree& tree,
+	    std::size_t i1, std::size_t i2);
+   };
+
+} // namespace Astl
+
+#endif
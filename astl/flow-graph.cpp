@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,6 +16,8 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <utility>
@@ -30,6 +32,9 @@ namespace Astl {
 #define LABELS "labels"
 #define ID "nextid"
 
+/* bumped whenever a link is added to any flow graph node */
+static std::atomic<std::size_t> current_generation(1);
+
 static std::size_t by_name(BindingsPtr bindings,
       const std::string& dict, const std::string& key) {
    if (key.size() == 0) return 0;
@@ -105,50 +110,106 @@ static std::size_t new_id(BindingsPtr bindings) {
    return id;
 }
 
+std::size_t flow_graph_generation() {
+   return current_generation.load();
+}
+
+std::size_t nof_node_ids(BindingsPtr bindings) {
+   if (!bindings) return 1;
+   AttributePtr graph = bindings->get("graph");
+   if (!graph) return 1;
+   if (graph->get_type() != Attribute::dictionary) return 1;
+   if (!graph->is_defined(ID)) return 1;
+   AttributePtr idAt = graph->get_value(ID);
+   assert(idAt);
+   Location loc;
+   return idAt->get_integer()->get_unsigned_int(loc);
+}
+
+void reverse_postorder(FlowGraphNodePtr root,
+      std::vector<FlowGraphNodePtr>& order) {
+   order.clear();
+   if (!root) return;
+   // iterative depth-first search as graphs may be deep
+   typedef std::pair<FlowGraphNodePtr, FlowGraphNode::Iterator> Frame;
+   std::vector<Frame> stack;
+   std::vector<bool> visited;
+   auto visit = [&](const FlowGraphNodePtr& node) {
+      std::size_t id = node->get_id();
+      if (id >= visited.size()) visited.resize(id + 1);
+      if (visited[id]) return;
+      visited[id] = true;
+      stack.push_back(Frame(node, node->begin_links()));
+   };
+   visit(root);
+   while (stack.size() > 0) {
+      Frame& frame = stack.back();
+      if (frame.second == frame.first->end_links()) {
+	 order.push_back(frame.first);
+	 stack.pop_back();
+      } else {
+	 FlowGraphNodePtr successor = frame.second->node;
+	 ++frame.second;
+	 visit(successor);
+      }
+   }
+   std::reverse(order.begin(), order.end());
+}
+
 FlowGraphNode::FlowGraphNode(BindingsPtr bindings) :
-      bindings(bindings), id(new_id(bindings)),
-      type_number(0), at(std::make_shared<Attribute>()) {
-   at->update("branch", std::make_shared<Attribute>());
+      bindings(bindings), id(new_id(bindings)), type_number(0) {
 }
 
 FlowGraphNode::FlowGraphNode(BindingsPtr bindings,
 	 const std::string& type) :
       bindings(bindings), id(new_id(bindings)), type(type),
-      type_number(node_type_by_name(bindings, type)),
-      at(std::make_shared<Attribute>()) {
-   at->update("branch", std::make_shared<Attribute>());
+      type_number(node_type_by_name(bindings, type)) {
 }
 
 FlowGraphNode::FlowGraphNode(BindingsPtr bindings, NodePtr node) :
       bindings(bindings), id(new_id(bindings)),
-      type_number(0), node(node),
-      at(std::make_shared<Attribute>()) {
+      type_number(0), node(node) {
    assert(node);
-   at->update("astnode", std::make_shared<Attribute>(node));
-   at->update("branch", std::make_shared<Attribute>());
 }
 
 FlowGraphNode::FlowGraphNode(BindingsPtr bindings,
 	 const std::string& type, NodePtr node) :
       bindings(bindings), id(new_id(bindings)),
       type(type), type_number(node_type_by_name(bindings, type)),
-      node(node), at(std::make_shared<Attribute>()) {
+      node(node) {
    assert(node);
-   at->update("astnode", std::make_shared<Attribute>(node));
-   at->update("branch", std::make_shared<Attribute>());
+}
+
+FlowGraphNode::FlowGraphNode(BindingsPtr bindings, std::size_t id,
+	 const std::string& type, std::size_t type_number, NodePtr node) :
+      bindings(bindings), id(id), type(type), type_number(type_number),
+      node(node) {
 }
 
 void FlowGraphNode::link(FlowGraphNodePtr fgnode) {
    assert(fgnode);
-   links.push_back(std::make_pair("", fgnode));
+   links.push_back(Link{"", 0, false, fgnode});
+   ++current_generation;
 }
 
 void FlowGraphNode::link(FlowGraphNodePtr fgnode, const std::string& label) {
    assert(fgnode);
-   links.push_back(std::make_pair(label, fgnode));
-   labeled_links[label] = fgnode;
-   AttributePtr branches = at->get_value("branch");
-   branches->update(label, std::make_shared<Attribute>(fgnode));
+   links.push_back(Link{label, label_by_name(bindings, label), true, fgnode});
+   ++current_generation;
+   if (at) {
+      AttributePtr branches = at->get_value("branch");
+      branches->update(label, std::make_shared<Attribute>(fgnode));
+   }
+}
+
+void FlowGraphNode::restore_link(const Link& link) {
+   assert(link.node);
+   links.push_back(link);
+   ++current_generation;
+   if (at && link.labeled) {
+      AttributePtr branches = at->get_value("branch");
+      branches->update(link.label, std::make_shared<Attribute>(link.node));
+   }
 }
 
 std::size_t FlowGraphNode::get_id() const {
@@ -168,6 +229,20 @@ NodePtr FlowGraphNode::get_node() const {
 }
 
 AttributePtr FlowGraphNode::get_attribute() const {
+   if (!at) {
+      at = std::make_shared<Attribute>();
+      if (node) {
+	 at->update("astnode", std::make_shared<Attribute>(node));
+      }
+      AttributePtr branches = std::make_shared<Attribute>();
+      for (auto& link: links) {
+	 if (link.labeled) {
+	    branches->update(link.label,
+	       std::make_shared<Attribute>(link.node));
+	 }
+      }
+      at->update("branch", branches);
+   }
    return at;
 }
 
@@ -175,6 +250,11 @@ std::size_t FlowGraphNode::get_number_of_outgoing_links() const {
    return links.size();
 }
 
+const FlowGraphNode::Link& FlowGraphNode::get_link(std::size_t index) const {
+   assert(index < links.size());
+   return links[index];
+}
+
 FlowGraphNode::Iterator FlowGraphNode::begin_links() const {
    return links.begin();
 }
@@ -184,20 +264,11 @@ FlowGraphNode::Iterator FlowGraphNode::end_links() const {
 }
 
 FlowGraphNodePtr FlowGraphNode::get_branch(const std::string& label) const {
-   BranchIterator it = labeled_links.find(label);
-   if (it == labeled_links.end()) {
-      return FlowGraphNodePtr(nullptr);
-   } else {
-      return it->second;
+   // the most recent link with the given label counts
+   for (auto it = links.rbegin(); it != links.rend(); ++it) {
+      if (it->labeled && it->label == label) return it->node;
    }
-}
-
-FlowGraphNode::BranchIterator FlowGraphNode::begin_branches() const {
-   return labeled_links.begin();
-}
-
-FlowGraphNode::BranchIterator FlowGraphNode::end_branches() const {
-   return labeled_links.end();
+   return FlowGraphNodePtr(nullptr);
 }
 
 } // namespace Astl
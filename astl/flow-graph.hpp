@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,9 +19,8 @@
 #ifndef ASTL_FLOW_GRAPH_H
 #define ASTL_FLOW_GRAPH_H
 
-#include <list>
-#include <map>
 #include <string>
+#include <vector>
 #include <boost/dynamic_bitset.hpp>
 #include <astl/types.hpp>
 
@@ -33,10 +32,14 @@ namespace Astl {
 
    class FlowGraphNode {
       public:
-	 typedef std::list<std::pair<std::string,
-	    FlowGraphNodePtr> >::const_iterator Iterator;
-	 typedef std::map<std::string, FlowGraphNodePtr>::const_iterator
-	    BranchIterator;
+	 /* outgoing edge; the label is interned when the link is made */
+	 struct Link {
+	    std::string label;
+	    std::size_t label_index; // see label_by_name
+	    bool labeled; // accessible through the branch dictionary
+	    FlowGraphNodePtr node;
+	 };
+	 typedef std::vector<Link>::const_iterator Iterator;
 
 	 // constructors
 	 FlowGraphNode(BindingsPtr bindings);
@@ -45,10 +48,18 @@ namespace Astl {
 	 FlowGraphNode(BindingsPtr bindings, NodePtr node);
 	 FlowGraphNode(BindingsPtr bindings,
 	    const std::string& type, NodePtr node);
+	 /* used when a flow graph is restored from a snapshot
+	    where ids and type numbers are to be preserved;
+	    node may be nullptr */
+	 FlowGraphNode(BindingsPtr bindings, std::size_t id,
+	    const std::string& type, std::size_t type_number,
+	    NodePtr node);
 
 	 // mutators
 	 void link(FlowGraphNodePtr fgnode);
 	 void link(FlowGraphNodePtr fgnode, const std::string& label);
+	 /* add a link with a label index of a restored flow graph */
+	 void restore_link(const Link& link);
 
 	 // accessors
 	 std::size_t get_id() const;
@@ -57,11 +68,10 @@ namespace Astl {
 	 NodePtr get_node() const;
 	 AttributePtr get_attribute() const;
 	 std::size_t get_number_of_outgoing_links() const;
+	 const Link& get_link(std::size_t index) const;
 	 Iterator begin_links() const;
 	 Iterator end_links() const;
 	 FlowGraphNodePtr get_branch(const std::string& label) const;
-	 BranchIterator begin_branches() const;
-	 BranchIterator end_branches() const;
 
       private:
 	 BindingsPtr bindings;
@@ -69,9 +79,10 @@ namespace Astl {
 	 std::string type;
 	 std::size_t type_number;
 	 NodePtr node;
-	 std::list<std::pair<std::string, FlowGraphNodePtr> > links;
-	 std::map<std::string, FlowGraphNodePtr> labeled_links;
-	 AttributePtr at;
+	 std::vector<Link> links;
+	 /* the attribute dictionary including the astnode and
+	    branch entries is created on its first access */
+	 mutable AttributePtr at;
    };
 
    std::size_t nof_node_types(BindingsPtr bindings);
@@ -80,6 +91,13 @@ namespace Astl {
    std::size_t nof_labels(BindingsPtr bindings);
    std::size_t label_by_name(BindingsPtr bindings,
       const std::string& label);
+   /* upper bound (exclusive) of the ids of all nodes created so far */
+   std::size_t nof_node_ids(BindingsPtr bindings);
+   /* changes whenever a link is added to any flow graph */
+   std::size_t flow_graph_generation();
+   /* all nodes reachable from root in reverse postorder */
+   void reverse_postorder(FlowGraphNodePtr root,
+      std::vector<FlowGraphNodePtr>& order);
 
 } // namespace Astl
 
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2010 Andreas Franz Borchert
+   Copyright (C) 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -20,6 +20,7 @@
 #define ASTL_GENERATOR_H
 
 #include <astl/exception.hpp>
+#include <astl/syntax-tree.hpp>
 #include <astl/types.hpp>
 
 namespace Astl {
@@ -29,6 +30,34 @@ namespace Astl {
 	 virtual NodePtr gen(int& argc, char**& argv) = 0;
    };
 
+   /**
+    * Generator that delivers the operands of the root, i.e.
+    * the top-level subtrees, one at a time. This permits run
+    * to execute the attribution rules for each of the top-level
+    * subtrees individually and to release them afterwards
+    * such that very large inputs need not be kept in memory.
+    * run falls back to the complete tree if the rules
+    * do not permit this (see run.hpp).
+    */
+   class StreamingSyntaxTreeGenerator: public SyntaxTreeGenerator {
+      public:
+	 /* returns the root without its operands */
+	 virtual NodePtr gen_root(int& argc, char**& argv) = 0;
+	 /* returns the next operand of the root, nullptr at the end */
+	 virtual NodePtr gen_operand() = 0;
+
+	 virtual NodePtr gen(int& argc, char**& argv) {
+	    NodePtr root = gen_root(argc, argv);
+	    if (root) {
+	       NodePtr operand;
+	       while ((operand = gen_operand())) {
+		  *root += operand;
+	       }
+	    }
+	    return root;
+	 }
+   };
+
 } // namespace Astl
 
 #endif
@@ -0,0 +1,143 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cassert>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <astl/intern.hpp>
+
+namespace Astl {
+
+// interned strings =========================================================
+
+/* the table is split into independently locked shards
+   to keep contention low when sources are parsed concurrently;
+   an entry is removed from its shard while its last reference is
+   dropped under the lock of the shard, hence all entries found
+   by intern_string have at least one reference */
+namespace {
+   struct StringShard {
+      std::mutex mutex;
+      std::unordered_multimap<std::size_t,
+	 std::unique_ptr<InternedString>> strings;
+   };
+   constexpr std::size_t string_shards = 32;
+
+   /* never destructed as tokens of static objects
+      may release their strings at exit */
+   StringShard& get_shard(std::size_t hashval) {
+      static StringShard* shards = new StringShard[string_shards];
+      return shards[hashval % string_shards];
+   }
+}
+
+const InternedString* intern_string(const std::string& s) {
+   if (s.empty()) return nullptr;
+   std::size_t hashval = std::hash<std::string>()(s);
+   StringShard& shard(get_shard(hashval));
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   auto range = shard.strings.equal_range(hashval);
+   for (auto it = range.first; it != range.second; ++it) {
+      if (it->second->text == s) {
+	 return retain_interned_string(it->second.get());
+      }
+   }
+   auto it = shard.strings.emplace(hashval,
+      std::make_unique<InternedString>(s, hashval));
+   return it->second.get();
+}
+
+void release_interned_string(const InternedString* s) {
+   if (!s) return;
+   std::size_t refs = s->refs.load(std::memory_order_relaxed);
+   while (refs > 1) {
+      if (s->refs.compare_exchange_weak(refs, refs - 1,
+	    std::memory_order_release, std::memory_order_relaxed)) {
+	 return;
+      }
+   }
+   StringShard& shard(get_shard(s->hashval));
+   std::lock_guard<std::mutex> lock(shard.mutex);
+   if (s->refs.fetch_sub(1, std::memory_order_acq_rel) > 1) return;
+   auto range = shard.strings.equal_range(s->hashval);
+   for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.get() == s) {
+	 shard.strings.erase(it); return;
+      }
+   }
+   assert(false);
+}
+
+/* operator names keep their reference forever */
+const char* intern_opname(const std::string& name) {
+   assert(!name.empty());
+   return intern_string(name)->text.c_str();
+}
+
+// interned filenames =======================================================
+
+namespace {
+   struct FilenameTable {
+      std::mutex mutex;
+      std::unordered_map<std::string, std::uint32_t> ids;
+      /* names[id-1]; a deque does not move its elements on growth */
+      std::deque<std::string> names;
+   };
+
+   FilenameTable& get_filename_table() {
+      static FilenameTable table;
+      return table;
+   }
+}
+
+/* tokens of the same source follow each other,
+   hence a per-thread cache of the last filename avoids
+   most of the lookups */
+
+std::uint32_t intern_filename(const std::string& filename) {
+   static thread_local std::uint32_t last_id = 0;
+   static thread_local const std::string* last_name = nullptr;
+   if (last_id > 0 && *last_name == filename) return last_id;
+   FilenameTable& table(get_filename_table());
+   std::lock_guard<std::mutex> lock(table.mutex);
+   auto it = table.ids.find(filename);
+   if (it == table.ids.end()) {
+      table.names.push_back(filename);
+      it = table.ids.emplace(filename, table.names.size()).first;
+   }
+   last_id = it->second; last_name = &table.names[last_id - 1];
+   return last_id;
+}
+
+const std::string& get_interned_filename(std::uint32_t id) {
+   static thread_local std::uint32_t last_id = 0;
+   static thread_local const std::string* last_name = nullptr;
+   assert(id > 0);
+   if (id != last_id) {
+      FilenameTable& table(get_filename_table());
+      std::lock_guard<std::mutex> lock(table.mutex);
+      assert(id <= table.names.size());
+      last_name = &table.names[id - 1]; last_id = id;
+   }
+   return *last_name;
+}
+
+} // namespace Astl
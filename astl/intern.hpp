@@ -0,0 +1,76 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_INTERN_H
+#define ASTL_INTERN_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Astl {
+
+   /*
+      Strings that are shared by many syntax tree nodes are interned,
+      i.e. kept just once per process such that they can be compared
+      by their addresses. Interned token strings are reference counted
+      and removed from the table as soon as the last reference is
+      released. Hence the table does not grow with the number of
+      subtrees a streaming generator delivers one at a time.
+      Operator names and filenames, in contrast, live until exit
+      as their number is bounded by the grammar and the sources.
+      All functions are thread-safe as sources may be parsed
+      concurrently.
+   */
+
+   struct InternedString {
+      InternedString(const std::string& text, std::size_t hashval) :
+	    text(text), hashval(hashval), refs(1) {
+      }
+      const std::string text;
+      const std::size_t hashval;
+      mutable std::atomic<std::size_t> refs;
+   };
+
+   /* return the interned copy of s with one reference added;
+      nullptr is returned for the empty string */
+   const InternedString* intern_string(const std::string& s);
+
+   /* add a reference to s, if not nullptr, and return s */
+   inline const InternedString* retain_interned_string(
+	 const InternedString* s) {
+      if (s) s->refs.fetch_add(1, std::memory_order_relaxed);
+      return s;
+   }
+
+   /* drop a reference of s, if not nullptr, which is
+      removed from the table with its last reference */
+   void release_interned_string(const InternedString* s);
+
+   /* return a copy of an operator name that lives until exit
+      as required by Operator(opcode, opname) */
+   const char* intern_opname(const std::string& name);
+
+   /* filenames are represented by small positive integers;
+      0 is reserved for undefined filenames */
+   std::uint32_t intern_filename(const std::string& filename);
+   const std::string& get_interned_filename(std::uint32_t id);
+
+} // namespace Astl
+
+#endif
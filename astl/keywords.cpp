@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,6 +16,9 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <astl/keywords.hpp>
 #include <astl/parser.hpp>
 #include <astl/scanner.hpp>
@@ -74,20 +77,56 @@ static struct {
    {"x", parser::token::X},
 };
 
-KeywordTable::KeywordTable() {
-   for (std::size_t i = 0; i < sizeof(keywords)/sizeof(keywords[0]); ++i) {
-      tab[keywords[i].keyword] = keywords[i].token;
+constexpr std::size_t nof_keywords = sizeof(keywords)/sizeof(keywords[0]);
+
+KeywordTable::KeywordTable() : maxlen(0), seed(0) {
+   for (std::size_t i = 0; i < nof_keywords; ++i) {
+      std::size_t len = std::strlen(keywords[i].keyword);
+      if (len > maxlen) maxlen = len;
+   }
+   /* try one seed after another until no collisions remain;
+      with a table that is more than five times as large
+      as the number of keywords this takes just a few trials */
+   for (;;) {
+      for (std::size_t i = 0; i < table_size; ++i) {
+	 tab[i] = Entry{nullptr, 0, 0};
+      }
+      bool ok = true;
+      for (std::size_t i = 0; ok && i < nof_keywords; ++i) {
+	 const char* keyword = keywords[i].keyword;
+	 std::size_t len = std::strlen(keyword);
+	 Entry& entry = tab[hash(keyword, len)];
+	 if (entry.keyword) {
+	    ok = false;
+	 } else {
+	    entry = Entry{keyword, len, keywords[i].token};
+	 }
+      }
+      if (ok) break;
+      ++seed; assert(seed != 0);
+   }
+}
+
+std::size_t KeywordTable::hash(const char* s, std::size_t len) const {
+   /* FNV-1a, with the seed mixed into the offset basis */
+   std::uint32_t h = 2166136261u ^ seed;
+   for (std::size_t i = 0; i < len; ++i) {
+      h ^= (unsigned char) s[i]; h *= 16777619u;
    }
+   h ^= h >> 15;
+   return h & (table_size - 1);
 }
 
 bool KeywordTable::lookup(const std::string& ident, int& token) const {
-   std::map<std::string, int>::const_iterator it = tab.find(ident);
-   if (it == tab.end()) {
+   std::size_t len = ident.size();
+   if (len == 0 || len > maxlen) return false;
+   const Entry& entry = tab[hash(ident.data(), len)];
+   if (entry.len != len ||
+	 std::memcmp(entry.keyword, ident.data(), len) != 0) {
       return false;
-   } else {
-      token = it->second;
-      return true;
    }
+   token = entry.token;
+   return true;
 }
 
 KeywordTable keyword_table;
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,11 +19,18 @@
 #ifndef ASTL_KEYWORDS_HPP
 #define ASTL_KEYWORDS_HPP
 
-#include <map>
+#include <cstddef>
 #include <string>
 
 namespace Astl {
 
+   /**
+    * Keywords are looked up in an open hash table without
+    * collisions. The seed of the hash function is selected
+    * at construction time such that every keyword has a slot
+    * of its own. Hence each lookup takes one hash computation
+    * and at most one comparison.
+    */
    class KeywordTable {
       public:
 	 // constructor
@@ -33,7 +40,17 @@ namespace Astl {
 	 bool lookup(const std::string& ident, int& token) const;
 
       private:
-	 std::map<std::string, int> tab;
+	 static constexpr std::size_t table_size = 256; // power of 2
+	 struct Entry {
+	    const char* keyword;
+	    std::size_t len;
+	    int token;
+	 };
+	 Entry tab[table_size];
+	 std::size_t maxlen;
+	 unsigned int seed;
+
+	 std::size_t hash(const char* s, std::size_t len) const;
    };
 
    extern KeywordTable keyword_table;
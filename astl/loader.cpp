@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -17,9 +17,15 @@
 */
 
 #include <cassert>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <astl/loader.hpp>
+#include <astl/operators.hpp>
 #include <astl/parser.hpp>
 #include <astl/scanner.hpp>
 
@@ -36,6 +42,121 @@ bool Loader::loaded(const std::string& name) const {
 NodePtr Loader::load(std::string name) {
    std::ifstream in;
    std::string path;
+   if (open(name, libpath, in, path)) {
+      NodePtr root;
+      auto it = prefetched.find(path);
+      if (it != prefetched.end()) {
+	 root = it->second;
+	 prefetched.erase(it);
+      } else {
+	 root = parse(in, path);
+      }
+      loaded_libs.insert(name);
+      return root;
+   }
+   throw Exception("unable to load Astl source '" + name + "'");
+}
+
+void Loader::add_library(const std::string& libname) {
+   assert(libname.length() > 0);
+   libpath.push_back(libname);
+}
+
+void Loader::add_library_in_front(const std::string& libname) {
+   assert(libname.length() > 0);
+   libpath.push_front(libname);
+}
+
+void Loader::set_cache_directory(const std::string& dirname) {
+   if (dirname.length() > 0) {
+      cache = std::make_unique<ModuleCache>(dirname);
+   } else {
+      cache = nullptr;
+   }
+}
+
+/*
+   the import graph is explored by a pool of worker threads where
+   each of them parses one source at a time and then queues the
+   sources imported by it that have not been seen before;
+   library clauses are considered as far as they precede an
+   import within the same source or its importers which is
+   just an approximation of the sequential order in which the
+   library path is extended -- this is harmless as load takes
+   only the trees of those paths it finds on its own; sources
+   that fail to parse are skipped such that load reports the
+   error in the regular order
+*/
+void Loader::prefetch(NodePtr root) {
+   struct Job {
+      std::string path;
+      LibPath libpath; // in effect for the imports of this source
+   };
+   std::mutex mutex;
+   std::condition_variable cv;
+   std::deque<Job> jobs;
+   unsigned int busy = 0;
+
+   auto expand = [&](NodePtr module, LibPath libs) {
+      NodePtr clauses = module->get_operand(0);
+      for (std::size_t i = 0; i < clauses->size(); ++i) {
+	 NodePtr clause = clauses->get_operand(i);
+	 Operator op = clause->get_op();
+	 if (op == Op::library_clause) {
+	    libs.push_front(clause->get_operand(0)->get_token().get_text());
+	 } else if (op == Op::import_clause) {
+	    std::string name = clause->get_operand(0)->get_token().get_text();
+	    if (loaded(name)) continue;
+	    std::ifstream in;
+	    std::string path;
+	    if (!open(name, libs, in, path)) continue;
+	    std::lock_guard<std::mutex> lock(mutex);
+	    if (prefetched_paths.insert(path).second) {
+	       jobs.push_back(Job{path, libs});
+	       cv.notify_one();
+	    }
+	 }
+      }
+   };
+
+   auto worker = [&]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      for (;;) {
+	 cv.wait(lock, [&]() { return jobs.size() > 0 || busy == 0; });
+	 if (jobs.size() == 0) break;
+	 Job job = std::move(jobs.front()); jobs.pop_front();
+	 ++busy;
+	 lock.unlock();
+	 NodePtr module;
+	 try {
+	    std::ifstream in(job.path);
+	    if (in) module = parse(in, job.path);
+	 } catch (...) {
+	    /* reported later by load */
+	 }
+	 if (module) expand(module, job.libpath);
+	 lock.lock();
+	 if (module) prefetched[job.path] = module;
+	 --busy;
+	 if (jobs.size() == 0 && busy == 0) cv.notify_all();
+      }
+   };
+
+   expand(root, libpath);
+   if (jobs.size() == 0) return;
+   unsigned int threads = std::thread::hardware_concurrency();
+   std::vector<std::thread> workers;
+   for (unsigned int i = 1; i < threads; ++i) {
+      workers.emplace_back(worker);
+   }
+   worker();
+   for (auto& t: workers) {
+      t.join();
+   }
+}
+
+bool Loader::open(std::string& name, const LibPath& libpath,
+      std::ifstream& in, std::string& path) {
    if (name[0] == '/') {
       in.open(name.c_str());
       path = name;
@@ -44,7 +165,7 @@ NodePtr Loader::load(std::string name) {
 	 /* strip leading './' */
 	 name = name.substr(2);
       }
-      for (std::list<std::string>::const_iterator it = libpath.begin();
+      for (LibPath::const_iterator it = libpath.begin();
 	    it != libpath.end(); ++it) {
 	 if (*it == ".") {
 	    path = name;
@@ -60,27 +181,22 @@ NodePtr Loader::load(std::string name) {
 	 if (in) break;
       }
    }
-   if (in) {
+   return !!in;
+}
+
+NodePtr Loader::parse(std::istream& in, const std::string& path) const {
+   NodePtr root;
+   ModuleCache::Stamp stamp;
+   if (cache) root = cache->lookup(path, stamp);
+   if (!root) {
       Scanner scanner(in, path);
-      NodePtr root;
       parser p(scanner, root);
       if (p.parse() != 0) {
 	 throw Exception("unable to parse '" + path + "'");
       }
-      loaded_libs.insert(name);
-      return root;
+      if (cache) cache->store(path, stamp, root);
    }
-   throw Exception("unable to load Astl source '" + name + "'");
-}
-
-void Loader::add_library(const std::string& libname) {
-   assert(libname.length() > 0);
-   libpath.push_back(libname);
-}
-
-void Loader::add_library_in_front(const std::string& libname) {
-   assert(libname.length() > 0);
-   libpath.push_front(libname);
+   return root;
 }
 
 } // namespace Astl
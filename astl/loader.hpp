@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,10 +19,14 @@
 #ifndef ASTL_LOADER_H
 #define ASTL_LOADER_H
 
+#include <fstream>
 #include <list>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <astl/exception.hpp>
+#include <astl/module-cache.hpp>
 #include <astl/syntax-tree.hpp>
 
 namespace Astl {
@@ -38,10 +42,25 @@ namespace Astl {
 	 NodePtr load(std::string name);
 	 void add_library(const std::string& libname);
 	 void add_library_in_front(const std::string& libname);
+	 /* parsed sources are cached in the given directory,
+	    caching is disabled for an empty string */
+	 void set_cache_directory(const std::string& dirname);
+	 /* parse all sources imported by root, directly or indirectly,
+	    concurrently such that subsequent invocations of load
+	    find them already parsed */
+	 void prefetch(NodePtr root);
 
       private:
+	 typedef std::list<std::string> LibPath;
 	 std::set<std::string> loaded_libs; // set of loaded libraries
-	 std::list<std::string> libpath;
+	 LibPath libpath;
+	 std::unique_ptr<ModuleCache> cache;
+	 std::set<std::string> prefetched_paths; // attempted to prefetch
+	 std::map<std::string, NodePtr> prefetched; // not yet loaded
+
+	 static bool open(std::string& name, const LibPath& libpath,
+	    std::ifstream& in, std::string& path);
+	 NodePtr parse(std::istream& in, const std::string& path) const;
    };
 
 } // namespace Astl
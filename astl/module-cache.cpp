@@ -0,0 +1,355 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <astl/binary-coding.hpp>
+#include <astl/intern.hpp>
+#include <astl/module-cache.hpp>
+#include <astl/yytname.hpp>
+
+namespace Astl {
+
+/*
+   Layout of a cache file, all integers are encoded as varints
+   with 7 bits per byte, least significant group first:
+
+      magic (8 bytes), grammar signature (8 bytes),
+      absolute path of the source, path of the source as it was
+      given to the parser (as it appears within locations),
+      size of the source,
+      modification time of the source in seconds and nanoseconds,
+      number of strings, strings (length followed by the bytes),
+      number of nodes, nodes
+
+   Nodes are stored in postorder where each node refers to its
+   subnodes by their ordinal numbers. Hence subtrees which are
+   shared within the tree remain shared. The last node is the root.
+   Each node consists of
+
+      flags (leaf, filename of begin defined, filename of end defined),
+      begin of location ([filename], line, column),
+      end of location ([filename], line, column),
+      and, for leaves, symbol value, text, and literal (as string indices)
+      or, for operator nodes, opcode, operator name (as string index),
+      number of subnodes, and the ordinal numbers of the subnodes.
+*/
+
+static const char magic[] = "ASTLMOD1";
+static constexpr std::size_t magic_len = 8;
+
+enum {leaf_flag = 1, begin_filename_flag = 2, end_filename_flag = 4};
+
+/* checksum of the sources of the scanner and the parser which
+   is passed by the Makefile; if unknown, trees are cached for
+   the same build only */
+#ifndef ASTL_GRAMMAR_SIGNATURE
+#define ASTL_GRAMMAR_SIGNATURE __DATE__ " " __TIME__
+#endif
+
+/* cached trees are valid for the same grammar only; the token
+   symbols cover the grammar symbols while the actions of the
+   parser are covered by the checksum of its sources */
+static std::uint64_t grammar_signature() {
+   static const std::uint64_t signature = []() {
+      std::uint64_t hash = fnv1a(magic, magic_len);
+      static const char sources[] = ASTL_GRAMMAR_SIGNATURE;
+      hash = fnv1a(sources, sizeof sources, hash);
+      for (std::size_t i = 0; yytname[i]; ++i) {
+	 hash = fnv1a(yytname[i], std::strlen(yytname[i]) + 1, hash);
+      }
+      return hash;
+   }();
+   return signature;
+}
+
+/* fills in all members of stamp but abspath */
+static bool get_stamp(const std::string& path, ModuleCache::Stamp& stamp) {
+   struct stat sb;
+   if (stat(path.c_str(), &sb) < 0) return false;
+   stamp.size = sb.st_size;
+   stamp.sec = sb.st_mtim.tv_sec;
+   stamp.nsec = sb.st_mtim.tv_nsec;
+   stamp.valid = true;
+   return true;
+}
+
+static bool get_absolute_path(const std::string& path, std::string& abspath) {
+   char buf[PATH_MAX];
+   if (!realpath(path.c_str(), buf)) return false;
+   abspath = buf;
+   return true;
+}
+
+static void encode_position(BinaryEncoder& enc, BinaryStringTable& strings,
+      const Position& pos) {
+   if (pos.is_filename_defined()) {
+      enc.put(strings.add_filename(pos.get_filename()));
+   }
+   enc.put(pos.get_line()); enc.put(pos.get_column());
+}
+
+static Position decode_position(BinaryDecoder& dec,
+      const std::vector<std::string>& strings, bool filename_defined) {
+   const std::string* filename = nullptr;
+   if (filename_defined) {
+      filename = &strings[dec.get_index(strings.size())];
+   }
+   std::size_t line = dec.get();
+   std::size_t column = dec.get();
+   return Position(filename, line, column);
+}
+
+/* returns false if the tree contains nodes that cannot be cached */
+static bool encode_tree(BinaryEncoder& enc, NodePtr root) {
+   BinaryStringTable strings;
+   BinaryEncoder nodes;
+   std::size_t count = 0;
+   /* only nodes with more than one owner may be shared */
+   std::unordered_map<const Node*, std::size_t> shared_ids;
+   struct Frame {
+      const Node* node;
+      bool shared;
+      std::size_t next; // next subnode to be visited
+      std::size_t first; // ids of the subnodes within subnode_ids
+   };
+   std::vector<Frame> stack;
+   std::vector<std::size_t> subnode_ids;
+   stack.push_back(Frame{root.get(), false, 0, 0});
+   while (stack.size() > 0) {
+      Frame& frame = stack.back();
+      const Node* node = frame.node;
+      if (!node->is_leaf() && frame.next < node->size()) {
+	 const NodePtr& subnode = node->get_operand(frame.next++);
+	 if (!subnode) return false;
+	 bool shared = subnode.use_count() > 1;
+	 if (shared) {
+	    auto it = shared_ids.find(subnode.get());
+	    if (it != shared_ids.end()) {
+	       subnode_ids.push_back(it->second); continue;
+	    }
+	 }
+	 stack.push_back(Frame{subnode.get(), shared, 0, subnode_ids.size()});
+	 continue;
+      }
+      if (node->has_attributes()) return false;
+      const Location& loc = node->get_location();
+      unsigned int flags = 0;
+      if (node->is_leaf()) flags |= leaf_flag;
+      if (loc.get_begin().is_filename_defined()) {
+	 flags |= begin_filename_flag;
+      }
+      if (loc.get_end().is_filename_defined()) flags |= end_filename_flag;
+      nodes.put(flags);
+      encode_position(nodes, strings, loc.get_begin());
+      encode_position(nodes, strings, loc.get_end());
+      if (node->is_leaf()) {
+	 const Token& token = node->get_token();
+	 if (!token.has_tokenval()) return false;
+	 nodes.put(token.get_tokenval());
+	 nodes.put(strings.add(token.get_text()));
+	 nodes.put(strings.add(token.get_literal()));
+      } else {
+	 Operator op = node->get_op();
+	 nodes.put(op.get_opcode());
+	 nodes.put(strings.add(op.get_name()));
+	 nodes.put(node->size());
+	 for (std::size_t i = frame.first; i < subnode_ids.size(); ++i) {
+	    nodes.put(subnode_ids[i]);
+	 }
+	 subnode_ids.resize(frame.first);
+      }
+      std::size_t id = count++;
+      if (frame.shared) shared_ids[node] = id;
+      subnode_ids.push_back(id);
+      stack.pop_back();
+   }
+   strings.encode(enc);
+   enc.put(count);
+   enc.put_raw(nodes.get_buffer().data(), nodes.get_buffer().size());
+   return true;
+}
+
+static NodePtr decode_tree(BinaryDecoder& dec) {
+   std::vector<std::string> strings(dec.get());
+   for (auto& s: strings) {
+      s = dec.get_string();
+   }
+   std::vector<NodePtr> nodes(dec.get());
+   if (nodes.size() == 0) throw MalformedBinaryData();
+   for (auto& node: nodes) {
+      unsigned int flags = dec.get();
+      Position begin = decode_position(dec, strings,
+	 flags & begin_filename_flag);
+      Position end = decode_position(dec, strings,
+	 flags & end_filename_flag);
+      Location loc(begin, end);
+      if (flags & leaf_flag) {
+	 unsigned int symbol = dec.get();
+	 if (symbol == 0) throw MalformedBinaryData();
+	 const std::string& text = strings[dec.get_index(strings.size())];
+	 const std::string& literal = strings[dec.get_index(strings.size())];
+	 node = std::make_shared<Node>(loc, Token(symbol, text, literal));
+      } else {
+	 unsigned int opcode = dec.get();
+	 const std::string& name = strings[dec.get_index(strings.size())];
+	 if (name.empty()) throw MalformedBinaryData();
+	 if (opcode > 0) {
+	    node = std::make_shared<Node>(loc,
+	       Operator(opcode, intern_opname(name)));
+	 } else {
+	    node = std::make_shared<Node>(loc, Operator(name));
+	 }
+	 std::size_t count = dec.get();
+	 /* subnodes precede their parents */
+	 std::size_t defined = &node - &nodes[0];
+	 for (std::size_t i = 0; i < count; ++i) {
+	    *node += nodes[dec.get_index(defined)];
+	 }
+      }
+   }
+   return nodes.back();
+}
+
+/* returns nullptr if the cached tree is outdated */
+static NodePtr decode_module(BinaryDecoder& dec, const std::string& path,
+      const ModuleCache::Stamp& stamp) {
+   if (std::memcmp(dec.get_raw(magic_len), magic, magic_len) != 0) {
+      return nullptr;
+   }
+   std::uint64_t signature;
+   std::memcpy(&signature, dec.get_raw(sizeof signature), sizeof signature);
+   if (signature != grammar_signature()) return nullptr;
+   if (dec.get_string() != stamp.abspath) return nullptr;
+   if (dec.get_string() != path) return nullptr;
+   if (dec.get() != stamp.size) return nullptr;
+   if (dec.get() != stamp.sec) return nullptr;
+   if (dec.get() != stamp.nsec) return nullptr;
+   return decode_tree(dec);
+}
+
+static void make_directories(const std::string& dir) {
+   for (std::size_t pos = 1; pos <= dir.size(); ++pos) {
+      if (pos == dir.size() || dir[pos] == '/') {
+	 mkdir(dir.substr(0, pos).c_str(), 0777);
+      }
+   }
+}
+
+// constructor ==============================================================
+
+ModuleCache::ModuleCache(const std::string& directory) :
+      directory(directory) {
+}
+
+// accessors ================================================================
+
+NodePtr ModuleCache::lookup(const std::string& path, Stamp& stamp) const {
+   stamp.valid = false;
+   if (!get_absolute_path(path, stamp.abspath) ||
+	 !get_stamp(stamp.abspath, stamp)) {
+      return nullptr;
+   }
+   int fd = open(get_cache_path(stamp.abspath).c_str(), O_RDONLY);
+   if (fd < 0) return nullptr;
+   struct stat sb;
+   if (fstat(fd, &sb) < 0 || sb.st_size == 0) {
+      close(fd); return nullptr;
+   }
+   std::size_t len = sb.st_size;
+   void* mem = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (mem == MAP_FAILED) return nullptr;
+   NodePtr root;
+   try {
+      const char* begin = static_cast<const char*>(mem);
+      BinaryDecoder dec(begin, begin + len);
+      root = decode_module(dec, path, stamp);
+   } catch (MalformedBinaryData&) {
+      root = nullptr;
+   }
+   munmap(mem, len);
+   return root;
+}
+
+void ModuleCache::store(const std::string& path, const Stamp& stamp,
+      NodePtr root) const {
+   if (!root || !stamp.valid) return;
+   BinaryEncoder enc;
+   enc.put_raw(magic, magic_len);
+   std::uint64_t signature = grammar_signature();
+   enc.put_raw(reinterpret_cast<const char*>(&signature), sizeof signature);
+   enc.put(stamp.abspath);
+   enc.put(path);
+   enc.put(stamp.size); enc.put(stamp.sec); enc.put(stamp.nsec);
+   if (!encode_tree(enc, root)) return;
+
+   make_directories(directory);
+   std::string cache_path = get_cache_path(stamp.abspath);
+   std::string tmp_path = cache_path + "." + std::to_string(getpid());
+   {
+      std::ofstream out(tmp_path, std::ios::binary);
+      if (!out) return;
+      const std::string& buf = enc.get_buffer();
+      out.write(buf.data(), buf.size());
+      out.close();
+      if (!out) {
+	 std::remove(tmp_path.c_str()); return;
+      }
+   }
+   if (std::rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+      std::remove(tmp_path.c_str());
+   }
+}
+
+// private methods ==========================================================
+
+std::string ModuleCache::get_cache_path(const std::string& abspath) const {
+   static const char hexdigits[] = "0123456789abcdef";
+   std::uint64_t hash = fnv1a(abspath.data(), abspath.size());
+   std::string name;
+   for (int i = 0; i < 16; ++i) {
+      name.push_back(hexdigits[hash & 0xf]); hash >>= 4;
+   }
+   return directory + "/" + name + ".astlc";
+}
+
+// default directory ========================================================
+
+std::string default_module_cache_directory() {
+   const char* dir = std::getenv("ASTL_ASTL_CACHE");
+   if (dir) return dir;
+   dir = std::getenv("XDG_CACHE_HOME");
+   if (dir && *dir) return std::string(dir) + "/astl";
+   dir = std::getenv("HOME");
+   if (dir && *dir) return std::string(dir) + "/.cache/astl";
+   return "";
+}
+
+} // namespace Astl
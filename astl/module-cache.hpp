@@ -0,0 +1,82 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_MODULE_CACHE_H
+#define ASTL_MODULE_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <astl/syntax-tree.hpp>
+
+namespace Astl {
+
+   /**
+    * Cache of parsed Astl sources in a compact binary format
+    * which permits the loader to skip the lexical analysis
+    * and the parser for sources that have been loaded before.
+    *
+    * Each source is cached in a separate file within the cache
+    * directory whose name is derived from the absolute path of
+    * the source. A cached tree is used only if the path, size,
+    * and modification time of the source and the grammar of the
+    * parser agree with those recorded when the tree was stored.
+    * Cache files are mapped into memory when they are read and
+    * replaced atomically when they are written. Any failure to
+    * read or write the cache is silently ignored as the source
+    * can be parsed instead.
+    */
+   class ModuleCache {
+      public:
+	 ModuleCache(const std::string& directory);
+
+	 /** absolute path, size, and modification time of a source */
+	 struct Stamp {
+	    bool valid; // false if the source could not be examined
+	    std::string abspath;
+	    std::uint64_t size;
+	    std::uint64_t sec;
+	    std::uint64_t nsec;
+	 };
+
+	 /**
+	  * Return nullptr if no valid cached tree exists. The stamp
+	  * is to be passed to store() if the source is parsed instead
+	  * such that changes of the source that take place while it
+	  * is parsed render the stored tree outdated.
+	  */
+	 NodePtr lookup(const std::string& path, Stamp& stamp) const;
+	 void store(const std::string& path, const Stamp& stamp,
+	    NodePtr root) const;
+
+      private:
+	 std::string directory;
+	 std::string get_cache_path(const std::string& abspath) const;
+   };
+
+   /**
+    * Return the cache directory to be used by default:
+    * $ASTL_ASTL_CACHE, if set, otherwise $XDG_CACHE_HOME/astl
+    * or $HOME/.cache/astl. An empty string is returned if
+    * caching is to be disabled, i.e. if $ASTL_ASTL_CACHE is
+    * set to an empty string or if no home directory is known.
+    */
+   std::string default_module_cache_directory();
+
+} // namespace Astl
+
+#endif
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2016 Andreas F. Borchert
+   Copyright (C) 2009, 2016, 2026 Andreas F. Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -23,25 +23,29 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <astl/intern.hpp>
 #include <astl/token.hpp>
 
 namespace Astl {
 
+   /*
+      Operators are identified by their opcode if they have one;
+      otherwise by their name. Names passed as strings are interned
+      such that an operator is just a code and a pointer.
+   */
    class Operator {
       public:
 	 // constructors
-	 Operator() : opcode(0), opname(nullptr), opstring() {}
+	 Operator() : opcode(0), opname(nullptr) {}
 	 Operator(unsigned int opcode, const char* opname) :
 	       opcode(opcode), opname(opname) {
 	    assert(opname != nullptr); assert(opcode != 0);
 	 }
 	 Operator(const std::string& opname) :
-	       opcode(0), opname(nullptr), opstring(opname) {
-	    assert(!opname.empty());
+	       opcode(0), opname(intern_opname(opname)) {
 	 }
 	 Operator(const Operator& other) :
-	       opcode(other.opcode), opname(other.opname),
-	       opstring(other.opstring) {
+	       opcode(other.opcode), opname(other.opname) {
 	 }
 
 	 // accessors
@@ -52,29 +56,23 @@ namespace Astl {
 	    if (opname) {
 	       return opname;
 	    } else {
-	       return opstring.c_str();
+	       return "";
 	    }
 	 }
 	 bool operator==(const Operator& other) const {
 	    if (opcode > 0 && other.opcode > 0) {
 	       return opcode == other.opcode;
+	    } else if (opname == other.opname) {
+	       return true;
 	    } else {
 	       return std::strcmp(get_name(), other.get_name()) == 0;
 	    }
 	 }
 	 bool operator==(const Token& other) const {
-	    if (opname) {
-	       return std::strcmp(opname, other.get_text().c_str()) == 0;
-	    } else {
-	       return opstring == other.get_text();
-	    }
+	    return std::strcmp(get_name(), other.get_text().c_str()) == 0;
 	 }
 	 bool operator==(const std::string& other) const {
-	    if (opname) {
-	       return std::strcmp(opname, other.c_str()) == 0;
-	    } else {
-	       return opstring == other;
-	    }
+	    return std::strcmp(get_name(), other.c_str()) == 0;
 	 }
 	 bool operator!=(const Operator& other) const {
 	    return !(*this == other);
@@ -90,14 +88,12 @@ namespace Astl {
 	 Operator& operator=(const Operator& other) {
 	    opcode = other.opcode;
 	    opname = other.opname;
-	    opstring = other.opstring;
 	    return *this;
 	 }
 
       private:
 	 unsigned int opcode;
-	 const char* opname;
-	 std::string opstring;
+	 const char* opname; // static or interned
    };
 
    inline std::ostream& operator<<(std::ostream& out, const Operator& op) {
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,6 +16,7 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <cassert>
 #include <memory>
 #include <astl/operator-table.hpp>
 #include <astl/parenthesizer.hpp>
@@ -23,42 +24,57 @@
 
 namespace Astl {
 
-void parenthesize(NodePtr root, const OperatorTable& optab,
-      const Operator& parentheses) {
-   if (root->is_leaf()) return;
+/*
+   return root with parentheses inserted where they are required;
+   shared nodes and their subnodes must not be modified, hence they
+   are replaced by unshared copies if some of their subtrees need
+   parentheses
+*/
+static NodePtr parenthesized(NodePtr root, const OperatorTable& optab,
+      const Operator& parentheses, bool below_shared) {
+   if (root->is_leaf()) return root;
+   below_shared = below_shared || root->is_shared();
    Operator op = root->get_op();
-   if (optab.included(op) && root->size() > 0) {
-      OperatorTable::Associativity assoc = optab.get_associativity(op);
-      OperatorTable::Rank rank = optab.get_rank(op);
-      for (std::size_t i = 0; i < root->size(); ++i) {
-	 NodePtr& subnode(root->get_operand(i));
-	 if (!subnode->is_leaf() && subnode->size() > 0) {
-	    NodePtr dnode(subnode);
-	    Operator inner_op = subnode->get_op();
-	    if (optab.included(inner_op)) {
-	       OperatorTable::Associativity inner_assoc =
-		  optab.get_associativity(inner_op);
-	       OperatorTable::Rank inner_rank = optab.get_rank(inner_op);
-	       assert(rank != inner_rank || assoc == inner_assoc);
-	       if (rank > inner_rank ||
-		     (rank == inner_rank &&
-			(assoc == OperatorTable::nonassoc ||
-			(assoc == OperatorTable::left && i > 0) ||
-			(assoc == OperatorTable::right && i == 0)))) {
-		  /* parentheses are required */
-		  dnode = subnode =
-		     std::make_shared<Node>(subnode->get_location(),
-			parentheses, subnode);
-	       }
+   bool ranked = optab.included(op) && root->size() > 0;
+   NodePtr result(root);
+   for (std::size_t i = 0; i < root->size(); ++i) {
+      NodePtr subnode(root->get_operand(i));
+      NodePtr dnode(parenthesized(subnode, optab, parentheses,
+	 below_shared));
+      if (ranked && !subnode->is_leaf() && subnode->size() > 0) {
+	 OperatorTable::Associativity assoc = optab.get_associativity(op);
+	 OperatorTable::Rank rank = optab.get_rank(op);
+	 Operator inner_op = subnode->get_op();
+	 if (optab.included(inner_op)) {
+	    OperatorTable::Associativity inner_assoc =
+	       optab.get_associativity(inner_op);
+	    OperatorTable::Rank inner_rank = optab.get_rank(inner_op);
+	    assert(rank != inner_rank || assoc == inner_assoc);
+	    if (rank > inner_rank ||
+		  (rank == inner_rank &&
+		     (assoc == OperatorTable::nonassoc ||
+		     (assoc == OperatorTable::left && i > 0) ||
+		     (assoc == OperatorTable::right && i == 0)))) {
+	       /* parentheses are required */
+	       dnode = std::make_shared<Node>(subnode->get_location(),
+		  parentheses, dnode);
 	    }
-	    parenthesize(dnode, optab, parentheses);
 	 }
       }
-   } else {
-      for (std::size_t i = 0; i < root->size(); ++i) {
-	 parenthesize(root->get_operand(i), optab, parentheses);
+      if (dnode != subnode) {
+	 if (below_shared && result == root) {
+	    result = std::make_shared<Node>(*root);
+	 }
+	 result->set_operand(i, dnode);
       }
    }
+   return result;
+}
+
+void parenthesize(NodePtr root, const OperatorTable& optab,
+      const Operator& parentheses) {
+   NodePtr result = parenthesized(root, optab, parentheses, false);
+   assert(result == root);
 }
 
 } // namespace Astl
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -25,6 +25,8 @@
 
 namespace Astl {
 
+   /* insert parentheses where required by the operator table;
+      root must not be shared while its subtrees may be */
    void parenthesize(NodePtr root, const OperatorTable& optab,
       const Operator& parentheses);
 
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010, 2016 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2016, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,12 +16,19 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <atomic>
+#include <cassert>
 #include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <astl/bindings.hpp>
 #include <astl/cloner.hpp>
+#include <astl/compiled-print-rule.hpp>
 #include <astl/context.hpp>
 #include <astl/default-bindings.hpp>
 #include <astl/expression.hpp>
@@ -39,17 +46,83 @@ namespace Astl {
 
 static constexpr int TAB_STOP = 8;
 
+/*
+   state of a print() invocation:
+
+   compiled print rules can be used only if none of their
+   variables is defined in the bindings passed to print();
+   this is checked once per print() invocation and rule
+
+   in concurrent mode, the rule table and the bindings must not
+   be updated: print rules are looked up in a local cache and
+   the status of all compiled print rules must be resolved in advance
+*/
+class PrintState {
+   public:
+      PrintState(const RuleTable& rules, BindingsPtr bindings) :
+	    rules(rules), bindings(bindings),
+	    status(rules.compiled_print_rules(), unknown),
+	    concurrent(false) {
+      }
+      PrintState(const PrintState& other, bool concurrent) :
+	    rules(other.rules), bindings(other.bindings),
+	    status(other.status), concurrent(concurrent) {
+      }
+      bool usable(const CompiledPrintRule& crule) {
+	 Status& s(status[crule.get_id()]);
+	 if (s == unknown) {
+	    assert(!concurrent);
+	    s = usable_rule;
+	    for (auto& name: crule.get_variables()) {
+	       if (bindings->defined(name)) {
+		  s = hidden; break;
+	       }
+	    }
+	 }
+	 return s == usable_rule;
+      }
+      void resolve_all() {
+	 for (std::size_t id = 0; id < status.size(); ++id) {
+	    usable(*rules.get_compiled_print_rule(id));
+	 }
+      }
+      const RuleTable::PrintCandidates& find_rules(const NodePtr& node) {
+	 if (!concurrent) {
+	    return rules.find_print_rules(node->get_op(), node->size());
+	 }
+	 RuleTable::PrintRuleKey key(node->get_op(), node->size());
+	 auto it = local_dispatch_table.find(key);
+	 if (it != local_dispatch_table.end()) {
+	    return it->second;
+	 }
+	 return local_dispatch_table[key] =
+	    rules.collect_print_rules(node->get_op(), node->size());
+      }
+      bool is_concurrent() const {
+	 return concurrent;
+      }
+   private:
+      typedef enum {unknown, usable_rule, hidden} Status;
+      const RuleTable& rules;
+      BindingsPtr bindings;
+      std::vector<Status> status;
+      bool concurrent;
+      std::unordered_map<RuleTable::PrintRuleKey, RuleTable::PrintCandidates,
+	 RuleTable::PrintRuleKeyHash> local_dispatch_table;
+};
+
 static bool recursive_print(std::ostream& out, const NodePtr root,
 	 const RuleTable& rules, BindingsPtr bindings, std::size_t indent,
-	 Context& context);
+	 Context& context, PrintState& state);
 
 static bool expand_variable(std::ostream& out, std::string name,
       const RuleTable& rules, std::size_t indent,
       BindingsPtr bindings, BindingsPtr local_bindings,
-      Context& context) {
+      Context& context, PrintState& state) {
    if (name.size() > 0 && local_bindings->defined(name)) {
       NodePtr node = local_bindings->get(name)->get_node();
-      return recursive_print(out, node, rules, bindings, indent, context);
+      return recursive_print(out, node, rules, bindings, indent, context,
+	 state);
    } else {
       return false;
    }
@@ -94,47 +167,94 @@ static void expand_text(std::ostream& out, const Token& t,
    }
 }
 
+/*
+   apply a compiled print rule to root where print_subtree(out, node, indent)
+   is invoked for all subtrees that are to be printed
+*/
+template<typename PrintSubtree>
+static void compiled_print(std::ostream& out, const NodePtr& root,
+	 const CompiledPrintRule& crule, std::size_t indent,
+	 PrintSubtree&& print_subtree) {
+   std::size_t add_indent = 0;
+   for (auto& item: crule.get_items()) {
+      switch (item.kind) {
+	 case CompiledPrintRule::Item::text: {
+	       const Token& t = item.literal->get_token();
+	       expand_text(out, t, indent);
+	       int new_indent = get_indent(t.get_text());
+	       if (new_indent >= 0) add_indent = new_indent;
+	       break;
+	    }
+	 case CompiledPrintRule::Item::subtree:
+	    print_subtree(out, crule.get_subtree(root, item.slot),
+	       indent + add_indent);
+	    break;
+	 case CompiledPrintRule::Item::subtrees: {
+	       std::size_t begin = crule.get_list_begin();
+	       std::size_t end = crule.get_list_end(root);
+	       for (std::size_t i = begin; i < end; ++i) {
+		  if (i > begin && item.literal) {
+		     const Token& t = item.literal->get_token();
+		     expand_text(out, t, indent);
+		     int new_indent = get_indent(t.get_text());
+		     if (new_indent >= 0) add_indent = new_indent;
+		  }
+		  print_subtree(out, root->get_operand(i), indent + add_indent);
+	       }
+	       break;
+	    }
+      }
+   }
+}
+
+/*
+   thrown by recursive_print in concurrent mode whenever a print rule
+   has to be applied that needs to be matched or evaluated using bindings
+*/
+struct SequentialPrintRequired {};
+
 static bool recursive_print(std::ostream& out, const NodePtr root,
 	 const RuleTable& rules, BindingsPtr bindings,
 	 std::size_t indent,
-	 Context& context) {
+	 Context& context, PrintState& state) {
    if (root->is_leaf()) {
       return !!(out << root->get_token().get_literal());
    } else {
-      Arity arity(root->size());
-      Operator op = root->get_op();
+      const RuleTable::PrintCandidates& candidates = state.find_rules(root);
       BindingsPtr local_bindings;
-      RuleTable::print_iterator it, end;
-      int found = 0;
-      for (it = rules.reversed_find(op, arity, end); it != end; ++it) {
-	 ++found;
+      auto it = candidates.begin();
+      for (; it != candidates.end(); ++it) {
+	 if (it->compiled && it->compiled->applicable(root) &&
+	       state.usable(*it->compiled)) {
+	    context.descend(root);
+	    compiled_print(out, root, *it->compiled, indent,
+	       [&](std::ostream& out, const NodePtr& node, std::size_t indent) {
+		  recursive_print(out, node, rules, bindings, indent,
+		     context, state);
+	       });
+	    context.ascend();
+	    return true;
+	 }
+	 if (state.is_concurrent()) {
+	    throw SequentialPrintRequired();
+	 }
 	 local_bindings = std::make_shared<Bindings>(bindings);
-	 if (matches(root, it->second->get_tree_expression(),
+	 if (matches(root, it->rule->get_tree_expression(),
 	       local_bindings, context)) break;
       }
-      if (it == end) {
-	 // try wildcard rules
-	 for (it = rules.reversed_find(op, Arity(), end);
-	       it != end; ++it) {
-	    ++found;
-	    local_bindings = std::make_shared<Bindings>(bindings);
-	    if (matches(root, it->second->get_tree_expression(),
-		  local_bindings, context)) break;
-	 }
-	 if (it == end) {
-	    std::ostringstream os;
-	    if (found > 0) {
-	       os << "no matching ";
-	    } else {
-	       os << "no ";
-	    }
-	    os << "rule found for '" << op.get_name() << "' with " <<
-	       root->size() << " parameters";
-	    throw Exception(root->get_location(), os.str());
+      if (it == candidates.end()) {
+	 std::ostringstream os;
+	 if (candidates.size() > 0) {
+	    os << "no matching ";
+	 } else {
+	    os << "no ";
 	 }
+	 os << "rule found for '" << root->get_op().get_name() << "' with " <<
+	    root->size() << " parameters";
+	 throw Exception(root->get_location(), os.str());
       }
       context.descend(root);
-      const NodePtr& node = it->second->get_rhs();
+      const NodePtr& node = it->rule->get_rhs();
       std::size_t add_indent = 0;
       for (std::size_t pi = 0; pi < node->size(); ++pi) {
 	 const NodePtr& subnode = node->get_operand(pi);
@@ -150,7 +270,7 @@ static bool recursive_print(std::ostream& out, const NodePtr root,
 	       case parser::token::VARIABLE:
 		  if (!expand_variable(out, t.get_text(), rules,
 			indent + add_indent,
-			bindings, local_bindings, context)) {
+			bindings, local_bindings, context, state)) {
 		     std::ostringstream os;
 		     os << "undefined variable in replacement text: " <<
 			t.get_text();
@@ -177,7 +297,7 @@ static bool recursive_print(std::ostream& out, const NodePtr root,
 	    }
 	    if (list->size() > 0) {
 	       recursive_print(out, list->get_value(0)->get_node(),
-		  rules, bindings, indent + add_indent, context);
+		  rules, bindings, indent + add_indent, context, state);
 	    }
 	    for (std::size_t i = 1; i < list->size(); ++i) {
 	       if (subnode->size() == 2) {
@@ -187,13 +307,13 @@ static bool recursive_print(std::ostream& out, const NodePtr root,
 		  if (new_indent >= 0) add_indent = new_indent;
 	       }
 	       recursive_print(out, list->get_value(i)->get_node(),
-		  rules, bindings, indent + add_indent, context);
+		  rules, bindings, indent + add_indent, context, state);
 	    }
 	 } else {
 	    assert(subnode->get_op() == Op::expression);
 	    Expression expr(subnode, local_bindings);
 	    if (!recursive_print(out, expr.convert_to_node(),
-		  rules, bindings, indent, context)) {
+		  rules, bindings, indent, context, state)) {
 	       return false;
 	    }
 	 }
@@ -203,21 +323,138 @@ static bool recursive_print(std::ostream& out, const NodePtr root,
    return true;
 }
 
+/*
+   concurrent printing: the operands of the root are printed
+   into individual buffers by a pool of worker threads and then
+   concatenated in order; this is possible only if the root
+   is printed by a compiled print rule; subtrees that need
+   other print rules are printed sequentially afterwards
+*/
+static bool concurrent_print(std::ostream& out, const NodePtr root,
+      const RuleTable& rules, BindingsPtr bindings, unsigned int threads,
+      Context& context, PrintState& state) {
+   const CompiledPrintRule* crule = nullptr;
+   if (!root->is_leaf()) {
+      const RuleTable::PrintCandidates& candidates = state.find_rules(root);
+      if (candidates.size() > 0 && candidates[0].compiled &&
+	    candidates[0].compiled->applicable(root) &&
+	    state.usable(*candidates[0].compiled)) {
+	 crule = candidates[0].compiled.get();
+      }
+   }
+   if (!crule) {
+      return recursive_print(out, root, rules, bindings, 0, context, state);
+   }
+
+   /* expand the text of the root node and collect its subtrees */
+   struct Task {
+      NodePtr node;
+      std::size_t indent;
+      std::size_t offset; // within text
+      std::string output;
+      bool sequential;
+      std::exception_ptr error;
+   };
+   std::vector<Task> tasks;
+   std::ostringstream text;
+   context.descend(root);
+   compiled_print(text, root, *crule, 0,
+      [&](std::ostream& out, const NodePtr& node, std::size_t indent) {
+	 tasks.push_back(Task{node, indent, (std::size_t) out.tellp(),
+	    "", false, nullptr});
+      });
+
+   /* print the subtrees concurrently */
+   state.resolve_all();
+   std::atomic<std::size_t> next_task(0);
+   auto worker = [&]() {
+      PrintState local_state(state, /* concurrent = */ true);
+      for (;;) {
+	 std::size_t index = next_task++;
+	 if (index >= tasks.size()) break;
+	 Task& task(tasks[index]);
+	 Context local_context(context);
+	 std::ostringstream os;
+	 try {
+	    recursive_print(os, task.node, rules, bindings, task.indent,
+	       local_context, local_state);
+	    task.output = os.str();
+	 } catch (SequentialPrintRequired&) {
+	    task.sequential = true;
+	 } catch (...) {
+	    task.error = std::current_exception();
+	 }
+      }
+   };
+   if (threads > tasks.size()) {
+      threads = tasks.size();
+   }
+   std::vector<std::thread> workers;
+   for (unsigned int i = 1; i < threads; ++i) {
+      workers.emplace_back(worker);
+   }
+   worker();
+   for (auto& t: workers) {
+      t.join();
+   }
+
+   /* concatenate everything in order */
+   std::string expanded_text = text.str();
+   std::size_t pos = 0;
+   for (auto& task: tasks) {
+      out.write(expanded_text.data() + pos, task.offset - pos);
+      pos = task.offset;
+      if (task.error) {
+	 std::rethrow_exception(task.error);
+      }
+      if (task.sequential) {
+	 recursive_print(out, task.node, rules, bindings, task.indent,
+	    context, state);
+      } else {
+	 out << task.output;
+      }
+   }
+   out.write(expanded_text.data() + pos, expanded_text.size() - pos);
+   context.ascend();
+   return !!out;
+}
+
 bool print(std::ostream& out, const NodePtr root,
       const RuleTable& rules) {
    Context context;
-   return recursive_print(out, root, rules,
-      create_default_bindings(root), 0, context);
+   BindingsPtr bindings = create_default_bindings(root);
+   PrintState state(rules, bindings);
+   return recursive_print(out, root, rules, bindings, 0, context, state);
 }
 
 bool print(std::ostream& out, const NodePtr root,
       const RuleTable& rules, BindingsPtr bindings) {
    Context context;
-   return recursive_print(out, root, rules, bindings, 0, context);
+   PrintState state(rules, bindings);
+   return recursive_print(out, root, rules, bindings, 0, context, state);
+}
+
+bool print(std::ostream& out, const NodePtr root,
+      const RuleTable& rules, BindingsPtr bindings, unsigned int threads) {
+   if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+   }
+   Context context;
+   PrintState state(rules, bindings);
+   if (threads <= 1) {
+      return recursive_print(out, root, rules, bindings, 0, context, state);
+   }
+   return concurrent_print(out, root, rules, bindings, threads,
+      context, state);
 }
 
 AttributePtr gen_text(const RuleTable& print_rules, NodePtr root,
       BindingsPtr bindings) {
+   return gen_text(print_rules, root, bindings, 1);
+}
+
+AttributePtr gen_text(const RuleTable& print_rules, NodePtr root,
+      BindingsPtr bindings, unsigned int threads) {
    const Rules& rules(bindings->get_rules());
    std::ostringstream os;
    if (rules.operator_rules_defined()) {
@@ -238,7 +475,7 @@ AttributePtr gen_text(const RuleTable& print_rules, NodePtr root,
       parenthesize(cloned_root, rules.get_operator_table(), parentheses);
       root = cloned_root;
    }
-   if (print(os, root, print_rules, bindings)) {
+   if (print(os, root, print_rules, bindings, threads)) {
       return std::make_shared<Attribute>(os.str());
    } else {
       return AttributePtr(nullptr);
@@ -246,6 +483,11 @@ AttributePtr gen_text(const RuleTable& print_rules, NodePtr root,
 }
 
 AttributePtr gen_text(NodePtr root, BindingsPtr bindings) {
+   return gen_text(root, bindings, 1);
+}
+
+AttributePtr gen_text(NodePtr root, BindingsPtr bindings,
+      unsigned int threads) {
    if (!bindings->rules_defined()) {
       throw Exception("no print rules defined");
    }
@@ -254,7 +496,7 @@ AttributePtr gen_text(NodePtr root, BindingsPtr bindings) {
       throw Exception("no print rules defined");
    }
    const RuleTable& print_rules(rules.get_print_rule_table());
-   return gen_text(print_rules, root, bindings);
+   return gen_text(print_rules, root, bindings, threads);
 }
 
 } // namespace Astl
@@ -31,10 +31,24 @@ namespace Astl {
       const RuleTable& rules);
    bool print(std::ostream& out, const NodePtr root,
       const RuleTable& rules, BindingsPtr bindings);
+   /**
+    * Print root using up to the given number of threads
+    * (0 selects the number of available cores). The operands
+    * of root are printed concurrently if root is printed by
+    * a print rule that just binds its subnodes positionally.
+    * Subtrees which need print rules with conditions,
+    * contexts, or expressions are printed sequentially.
+    */
+   bool print(std::ostream& out, const NodePtr root,
+      const RuleTable& rules, BindingsPtr bindings, unsigned int threads);
    AttributePtr gen_text(NodePtr root,
       BindingsPtr bindings);
+   AttributePtr gen_text(NodePtr root,
+      BindingsPtr bindings, unsigned int threads);
    AttributePtr gen_text(const RuleTable& print_rules, NodePtr root,
 	 BindingsPtr bindings);
+   AttributePtr gen_text(const RuleTable& print_rules, NodePtr root,
+	 BindingsPtr bindings, unsigned int threads);
 
 } // namespace Astl
 
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -61,6 +61,16 @@ void RuleTable::traverse(NodePtr node,
 	 }
 	 it->second.insert(value_pair(++current_rank, rule));
       }
+      /* print rules which just bind their subnodes positionally
+	 are compiled such that they can be applied without bindings */
+      if (ruleop == Op::print_rule) {
+	 CompiledPrintRulePtr crule = CompiledPrintRule::compile(rule,
+	    compiled_rules.size());
+	 if (crule) {
+	    compiled_rules.push_back(crule);
+	    compiled_rule_index[rule] = crule;
+	 }
+      }
    } else {
       /* recursive traverse */
       for (std::size_t i = 0; i < node->size(); ++i) {
@@ -71,6 +81,65 @@ void RuleTable::traverse(NodePtr node,
 
 void RuleTable::scan(NodePtr root, const Operator& ruleop, const Rules& rules) {
    traverse(root, ruleop, rules);
+   dispatch_table.clear();
+}
+
+/* check whether a context of the given tree expression
+   could possibly be matched by a node with the given operator */
+static bool context_depends_on(NodePtr expression, const Operator& op,
+      const Rules& rules) {
+   if (expression->get_op() == Op::conditional_tree_expression) {
+      expression = expression->get_operand(0);
+   }
+   if (expression->get_op() != Op::contextual_tree_expression) {
+      return false;
+   }
+   NodePtr context_expression = expression->get_operand(1);
+   while (context_expression) {
+      NodePtr next_expression;
+      if (!context_expression->is_leaf() &&
+	    context_expression->get_op() == Op::NOT) {
+	 context_expression = context_expression->get_operand(0);
+      }
+      if (!context_expression->is_leaf() &&
+	    context_expression->get_op() == Op::context_expression) {
+	 next_expression = context_expression->get_operand(1);
+	 context_expression = context_expression->get_operand(0);
+      }
+      assert(!context_expression->is_leaf() &&
+	 context_expression->get_op() == Op::context_match);
+      NodePtr match = context_expression->get_operand(0);
+      while (!match->is_leaf() &&
+	    match->get_op() == Op::named_tree_expression) {
+	 match = match->get_operand(0);
+      }
+      if (!match->is_leaf() &&
+	    match->get_op() == Op::variable_length_tree_expression) {
+	 match = match->get_operand(0);
+      }
+      if (match->is_leaf() || match->get_op() != Op::tree_expression) {
+	 /* variables and token patterns are not examined */
+	 return true;
+      }
+      OperatorSet opset(match->get_operand(0), rules);
+      if (opset.includes(op)) return true;
+      context_expression = next_expression;
+   }
+   return false;
+}
+
+bool RuleTable::independent_of(const Operator& op, const Rules& rules) const {
+   std::string opname(op.get_name());
+   for (auto& rt: table) {
+      for (auto& entry: rt) {
+	 if (entry.first.first == opname) return false;
+	 for (auto& ranked_rule: entry.second) {
+	    NodePtr expression = ranked_rule.second->get_tree_expression();
+	    if (context_depends_on(expression, op, rules)) return false;
+	 }
+      }
+   }
+   return true;
 }
 
 RuleTable::iterator RuleTable::find_prefix(const Operator& op,
@@ -112,6 +181,43 @@ RuleTable::print_iterator RuleTable::reversed_find(const Operator& op,
    }
 }
 
+const RuleTable::PrintCandidates& RuleTable::find_print_rules(
+      const Operator& op, std::size_t arity) const {
+   PrintRuleKey key(op, arity);
+   auto it = dispatch_table.find(key);
+   if (it != dispatch_table.end()) {
+      return it->second;
+   }
+   return dispatch_table[key] = collect_print_rules(op, arity);
+}
+
+RuleTable::PrintCandidates RuleTable::collect_print_rules(
+      const Operator& op, std::size_t arity) const {
+   PrintCandidates candidates;
+   Arity arities[] = {Arity(arity), Arity()};
+   for (const Arity& a: arities) {
+      print_iterator pit, end;
+      for (pit = reversed_find(op, a, end); pit != end; ++pit) {
+	 CompiledPrintRulePtr crule;
+	 auto cit = compiled_rule_index.find(pit->second);
+	 if (cit != compiled_rule_index.end()) {
+	    crule = cit->second;
+	 }
+	 candidates.push_back(PrintCandidate{pit->second, crule});
+      }
+   }
+   return candidates;
+}
+
+std::size_t RuleTable::compiled_print_rules() const {
+   return compiled_rules.size();
+}
+
+CompiledPrintRulePtr RuleTable::get_compiled_print_rule(std::size_t id) const {
+   assert(id < compiled_rules.size());
+   return compiled_rules[id];
+}
+
 std::size_t RuleTable::size() const {
    return current_rank;
 }
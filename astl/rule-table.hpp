@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -23,6 +23,9 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
+#include <astl/compiled-print-rule.hpp>
 #include <astl/operator.hpp>
 #include <astl/rule.hpp>
 #include <astl/types.hpp>
@@ -39,6 +42,41 @@ namespace Astl {
 	 typedef std::map<key_pair, submap_type> map_type;
 	 typedef submap_type::const_iterator iterator;
 	 typedef submap_type::const_reverse_iterator print_iterator;
+	 /**
+	  * A print rule candidate along with its compiled
+	  * form, if the rule was suitable for compilation.
+	  */
+	 struct PrintCandidate {
+	    RulePtr rule;
+	    CompiledPrintRulePtr compiled;
+	 };
+	 typedef std::vector<PrintCandidate> PrintCandidates;
+	 /**
+	  * Key for the print rule candidates of an operator node:
+	  * operators with an opcode are identified by their opcode,
+	  * all others by their name.
+	  */
+	 struct PrintRuleKey {
+	    PrintRuleKey(const Operator& op, std::size_t arity) :
+		  opcode(op.get_opcode()), arity(arity) {
+	       if (opcode == 0) {
+		  opname = op.get_name();
+	       }
+	    }
+	    bool operator==(const PrintRuleKey& other) const {
+	       return opcode == other.opcode && arity == other.arity &&
+		  opname == other.opname;
+	    }
+	    unsigned int opcode;
+	    std::string opname;
+	    std::size_t arity;
+	 };
+	 struct PrintRuleKeyHash {
+	    std::size_t operator()(const PrintRuleKey& key) const {
+	       return std::hash<std::string>()(key.opname) ^
+		  (key.opcode * 31 + key.arity) * 0x9e3779b9;
+	    }
+	 };
 	 // constructor
 	 RuleTable();
 
@@ -64,11 +102,48 @@ namespace Astl {
 	  */
 	 print_iterator reversed_find(const Operator& op, Arity arity,
 	    print_iterator& end) const;
+	 /**
+	  * Returns all print rules that are to be tried for
+	  * an operator node with the given number of subnodes,
+	  * i.e. those with a fixed arity in the reverse order of
+	  * appearance, followed by the wildcard rules in the
+	  * reverse order of appearance. The result is memoized
+	  * per operator and arity.
+	  */
+	 const PrintCandidates& find_print_rules(const Operator& op,
+	    std::size_t arity) const;
+	 /**
+	  * Like find_print_rules but without memoization such
+	  * that it can be used concurrently.
+	  */
+	 PrintCandidates collect_print_rules(const Operator& op,
+	    std::size_t arity) const;
+	 /**
+	  * Returns the number of compiled print rules which
+	  * are numbered from 0 to compiled_print_rules() - 1.
+	  */
+	 std::size_t compiled_print_rules() const;
+	 CompiledPrintRulePtr get_compiled_print_rule(std::size_t id) const;
 	 std::size_t size() const;
+	 /**
+	  * Returns true if no rule applies to nodes with the given
+	  * operator and no context expression of a rule can be
+	  * satisfied by such a node. If this holds for the operator
+	  * of the root, the rules can be applied to each of the
+	  * operands of the root individually.
+	  */
+	 bool independent_of(const Operator& op, const Rules& rules) const;
 
       private:
 	 Rank current_rank;
 	 map_type table[2]; // prefix and postfix tables
+	 std::vector<CompiledPrintRulePtr> compiled_rules; // indexed by id
+	 std::map<RulePtr, CompiledPrintRulePtr> compiled_rule_index;
+
+	 /* memoized results of find_print_rules */
+	 mutable std::unordered_map<PrintRuleKey, PrintCandidates,
+	    PrintRuleKeyHash> dispatch_table;
+
 	 void traverse(NodePtr node,
 	    const Operator& ruleop, const Rules& rules);
 	 iterator find(const Operator& op, Arity arity,
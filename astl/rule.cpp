@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -27,12 +27,12 @@ namespace Astl {
 // ==== BasicRule =============================================================
 
 BasicRule::BasicRule(const Rules& rules_param) :
-   rules(rules_param), arity(0), type(prefix) {
+   rules(rules_param), arity(0), type(prefix), structural(true) {
 }
 
 BasicRule::BasicRule(NodePtr tree_expr_param, const Rules& rules_param) :
       rules(rules_param), tree_expr(tree_expr_param),
-      arity(0), type(prefix) {
+      arity(0), type(prefix), structural(true) {
    assert(tree_expr && !tree_expr->is_leaf());
    NodePtr node = tree_expr;
    if (node->get_op() == Op::PRE) {
@@ -43,9 +43,11 @@ BasicRule::BasicRule(NodePtr tree_expr_param, const Rules& rules_param) :
    }
    if (node->get_op() == Op::conditional_tree_expression) {
       node = node->get_operand(0);
+      structural = false;
    }
    if (node->get_op() == Op::contextual_tree_expression) {
       node = node->get_operand(0);
+      structural = false;
    }
    if (node->get_op() == Op::named_tree_expression) {
       node = node->get_operand(0);
@@ -79,6 +81,10 @@ const BasicRule::Type BasicRule::get_type() const {
    return type;
 }
 
+bool BasicRule::is_structural() const {
+   return structural;
+}
+
 // ==== Rule ==================================================================
 
 Rule::Rule(NodePtr tree_expression_param,
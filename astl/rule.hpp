@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2016 Andreas Franz Borchert
+   Copyright (C) 2009, 2016, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -42,6 +42,10 @@ namespace Astl {
 	 Arity get_arity() const;
 	 const NodePtr get_tree_expression() const;
 	 const Type get_type() const;
+	 /* true if the tree expression has neither a context
+	    nor a where clause, i.e. if the outcome of a match
+	    depends on the subtree and the bindings only */
+	 bool is_structural() const;
 
       protected:
 	 const Rules& rules;
@@ -50,6 +54,7 @@ namespace Astl {
 	 OperatorSetPtr opset;
 	 Arity arity;
 	 Type type;
+	 bool structural;
    };
 
    class Rule: public BasicRule {
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2019 Andreas Franz Borchert
+   Copyright (C) 2009-2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -60,6 +60,15 @@ void Rules::add_to_named_rules(NamedRulesTable& nrtab,
 void Rules::scan(NodePtr root) {
    assert(!root->is_leaf());
    assert(root->get_op() == Op::unit && root->size() == 2);
+   /* parse imported modules concurrently in advance;
+      they are nonetheless processed in the order of their imports */
+   loader.prefetch(root);
+   scan_module(root);
+}
+
+void Rules::scan_module(NodePtr root) {
+   assert(!root->is_leaf());
+   assert(root->get_op() == Op::unit && root->size() == 2);
 
    // process clauses
    NodePtr clauses = root->get_operand(0);
@@ -74,7 +83,7 @@ void Rules::scan(NodePtr root) {
 	 std::string name = clause->get_operand(0)->get_token().get_text();
 	 if (!loader.loaded(name)) {
 	    try {
-	       scan(loader.load(name));
+	       scan_module(loader.load(name));
 	    } catch (Exception& e) {
 	       throw Exception(clause->get_location(), "imported from here", e);
 	    }
@@ -228,6 +237,10 @@ NodePtr Rules::get_function(const std::string& fname) const {
    return it->second;
 }
 
+bool Rules::state_machines_defined() const {
+   return smnodes.size() > 0 || asmnodes.size() > 0;
+}
+
 const StateMachineTable& Rules::get_sm_table(BindingsPtr bindings_param) const {
    if (bindings_param != bindings) {
       bindings = bindings_param;
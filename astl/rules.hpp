@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2019 Andreas Franz Borchert
+   Copyright (C) 2009-2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -67,6 +67,7 @@ namespace Astl {
 	 const FunctionTable& get_function_table() const;
 	 NodePtr get_function(const std::string& fname) const;
 
+	 bool state_machines_defined() const;
 	 const StateMachineTable& get_sm_table(BindingsPtr bindings_param)
 	    const;
 
@@ -98,6 +99,7 @@ namespace Astl {
 	 std::list<NodePtr> smnodes; // state machines
 	 std::list<NodePtr> asmnodes; // abstract state machines
 
+	 void scan_module(NodePtr root);
 	 void add_to_named_rules(NamedRulesTable& nrtab,
 	    const std::string& name, NodePtr root, const Operator& ruleop);
    };
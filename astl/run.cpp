@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2019 Andreas Franz Borchert
+   Copyright (C) 2009-2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -35,6 +35,7 @@
 #include <astl/rules.hpp>
 #include <astl/run.hpp>
 #include <astl/sm-execution.hpp>
+#include <astl/subtree-table.hpp>
 #include <astl/syntax-tree.hpp>
 
 namespace Astl {
@@ -103,36 +104,14 @@ class MyConsumer: public Consumer {
       std::ostream& out;
 };
 
-void run(NodePtr root,
-      Loader& loader,
-      const char* rules_filename, const char* pattern,
-      std::size_t count,
-      const Operator& parentheses,
-      std::ostream& out,
-      BindingsPtr extra_bindings,
-      int argc, char** argv) {
-   Rules rules(loader.load(rules_filename), loader);
-
-   // setup default bindings
-   BindingsPtr bindings = create_default_bindings(root, &rules, extra_bindings);
-
-   if (root) {
-      // execute global attribution rules, if defined
-      if (rules.attribution_rules_defined()) {
-	 try {
-	    execute(root, rules.get_attribution_rule_table(), bindings);
-	 } catch (Exception& e) {
-	    throw Exception("within attribution rules", e);
-	 }
-      }
-      // execute state machines, if present
-      try {
-	 execute_state_machines(rules, bindings);
-      } catch (Exception& e) {
-	 throw Exception("while executing state machines", e);
-      }
-   }
+static void no_matching_rule(const char* rules_filename) {
+   std::ostringstream os;
+   os << "no matching transformation rule found in " << rules_filename;
+   throw Exception(os.str());
+}
 
+static void run_main(const Rules& rules, BindingsPtr bindings,
+      int argc, char** argv) {
    NodePtr main = rules.get_function("main");
    if (main) {
       // collect remaining arguments for main()
@@ -166,31 +145,141 @@ void run(NodePtr root,
 	 throw Exception(main->get_location(), "within main", e);
       }
    }
+}
+
+/* if unique is true and duplicates is non-null, the number
+   of skipped duplicates is stored in *duplicates */
+static void run(NodePtr root,
+      Rules& rules,
+      const char* rules_filename, const char* pattern,
+      std::size_t count, bool unique, std::size_t* duplicates,
+      const Operator& parentheses,
+      std::ostream& out,
+      BindingsPtr extra_bindings,
+      int argc, char** argv) {
+   // setup default bindings
+   BindingsPtr bindings = create_default_bindings(root, &rules, extra_bindings);
+
+   if (root) {
+      // execute global attribution rules, if defined
+      if (rules.attribution_rules_defined()) {
+	 try {
+	    execute(root, rules.get_attribution_rule_table(), bindings);
+	 } catch (Exception& e) {
+	    throw Exception("within attribution rules", e);
+	 }
+      }
+      // execute state machines, if present
+      try {
+	 execute_state_machines(rules, bindings);
+      } catch (Exception& e) {
+	 throw Exception("while executing state machines", e);
+      }
+   }
+
+   run_main(rules, bindings, argc, argv);
 
    if (root && rules.print_rules_defined() &&
 	    rules.transformation_rules_defined()) {
+      /* subtrees are not shared before all other rules and main
+	 have been executed as the occurrences of a shared subtree
+	 would share their attributes as well */
+      auto locations = std::make_shared<OccurrenceLocations>();
+      root = share_subtrees(root, *locations);
       std::random_device random;
       PseudoRandomGeneratorPtr prg = std::make_shared<mt19937>(random());
       const RuleTable& rt(rules.get_transformation_rule_table());
       CandidateSet candidates(root, rt, bindings);
-      if (candidates.size() == 0) {
-	 std::ostringstream os;
-	 os << "no matching transformation rule found in " << rules_filename;
-	 throw Exception(os.str());
-      }
-      if (count < candidates.size()) {
-	 count = candidates.size();
-      }
-      ConsumerPtr consumer = std::make_shared<MyConsumer>(pattern, rules, count,
-	 parentheses, out, bindings);
       candidates.set_prg(prg);
-      candidates.set_consumer(consumer);
-      if (count == candidates.size()) {
+      candidates.set_occurrence_locations(locations);
+      if (unique) {
+	 candidates.suppress_duplicates();
+      }
+      if (count > 0) {
+	 /* sample count candidates without materializing all of them */
+	 ConsumerPtr consumer = std::make_shared<MyConsumer>(pattern, rules,
+	    count, parentheses, out, bindings);
+	 candidates.set_consumer(consumer);
+	 if (candidates.gen_mutations(count) == 0) {
+	    no_matching_rule(rules_filename);
+	 }
+      } else if (candidates.size() > 0) {
+	 ConsumerPtr consumer = std::make_shared<MyConsumer>(pattern, rules,
+	    candidates.size(), parentheses, out, bindings);
+	 candidates.set_consumer(consumer);
 	 candidates.gen_mutations();
       } else {
-	 candidates.gen_mutations(count);
+	 no_matching_rule(rules_filename);
+      }
+      if (unique && duplicates) {
+	 *duplicates = candidates.get_number_of_duplicates();
+      }
+   }
+}
+
+void run(NodePtr root,
+      Loader& loader,
+      const char* rules_filename, const char* pattern,
+      std::size_t count, bool unique, std::size_t* duplicates,
+      const Operator& parentheses,
+      std::ostream& out,
+      BindingsPtr extra_bindings,
+      int argc, char** argv) {
+   Rules rules(loader.load(rules_filename), loader);
+   run(root, rules, rules_filename, pattern, count, unique, duplicates,
+      parentheses, out, extra_bindings, argc, argv);
+}
+
+/* the operands of a root with the given operator can be processed
+   individually if nothing but context-independent attribution rules
+   and main are to be executed */
+static bool streamable(const Rules& rules, const Operator& op) {
+   if (rules.state_machines_defined()) return false;
+   if (rules.print_rules_defined() &&
+	 rules.transformation_rules_defined()) {
+      return false;
+   }
+   if (rules.attribution_rules_defined() &&
+	 !rules.get_attribution_rule_table().independent_of(op, rules)) {
+      return false;
+   }
+   return true;
+}
+
+/* streaming variant of the standard execution order where the
+   attribution rules are executed for one top-level subtree at a time
+   which is released afterwards; main sees the root without operands */
+static void run(StreamingSyntaxTreeGenerator& astgen,
+      int& argc, char**& argv, Loader& loader, const char* script_name,
+      const Operator& parentheses, BindingsPtr extra_bindings) {
+   NodePtr root = astgen.gen_root(argc, argv);
+   if (!root) {
+      throw Exception("no abstract syntax tree has been generated");
+   }
+   Rules rules(loader.load(script_name), loader);
+   NodePtr operand;
+   if (root->is_leaf() || !streamable(rules, root->get_op())) {
+      while ((operand = astgen.gen_operand())) {
+	 *root += operand;
+      }
+      run(root, rules, script_name, /* pattern= */ nullptr, /* count = */ 0,
+	 /* unique = */ false, /* duplicates = */ nullptr, parentheses,
+	 std::cout, extra_bindings, argc, argv);
+      return;
+   }
+
+   BindingsPtr bindings = create_default_bindings(root, &rules, extra_bindings);
+   while ((operand = astgen.gen_operand())) {
+      if (rules.attribution_rules_defined()) {
+	 try {
+	    execute(operand, rules.get_attribution_rule_table(), bindings);
+	 } catch (Exception& e) {
+	    throw Exception("within attribution rules", e);
+	 }
+	 operand->clear_contexts();
       }
    }
+   run_main(rules, bindings, argc, argv);
 }
 
 void run(NodePtr root,
@@ -200,8 +289,32 @@ void run(NodePtr root,
       std::ostream& out,
       BindingsPtr extra_bindings) {
    Loader loader;
-   run(root, loader, rules_filename, pattern, count, parentheses, out,
-      extra_bindings, 0, 0);
+   run(root, loader, rules_filename, pattern, count, false, nullptr,
+      parentheses, out, extra_bindings, 0, 0);
+}
+
+void run(NodePtr root,
+      const char* rules_filename, const char* pattern,
+      std::size_t count, bool unique,
+      const Operator& parentheses,
+      std::ostream& out,
+      BindingsPtr extra_bindings) {
+   Loader loader;
+   run(root, loader, rules_filename, pattern, count, unique, nullptr,
+      parentheses, out, extra_bindings, 0, 0);
+}
+
+void run(NodePtr root,
+      const char* rules_filename, const char* pattern,
+      std::size_t count, bool unique,
+      const Operator& parentheses,
+      std::ostream& out,
+      BindingsPtr extra_bindings,
+      std::size_t& duplicates) {
+   Loader loader;
+   duplicates = 0;
+   run(root, loader, rules_filename, pattern, count, unique, &duplicates,
+      parentheses, out, extra_bindings, 0, 0);
 }
 
 void run(NodePtr root,
@@ -210,8 +323,8 @@ void run(NodePtr root,
       const Operator& parentheses,
       std::ostream& out) {
    Loader loader;
-   run(root, loader, rules_filename, pattern, count, parentheses, out,
-      nullptr, 0, 0);
+   run(root, loader, rules_filename, pattern, count, false, nullptr,
+      parentheses, out, nullptr, 0, 0);
 }
 
 void usage(char* cmdname) {
@@ -259,12 +372,20 @@ void run(int& argc, char**& argv, SyntaxTreeGenerator& astgen,
    extra_bindings = define_cmdname(extra_bindings, script_name);
    /* generate AST */
    if (argc == 0) usage(cmdname);
+   StreamingSyntaxTreeGenerator* streaming =
+      dynamic_cast<StreamingSyntaxTreeGenerator*>(&astgen);
+   if (streaming) {
+      run(*streaming, argc, argv, loader, script_name, parentheses,
+	 extra_bindings);
+      return;
+   }
    NodePtr root = astgen.gen(argc, argv);
    if (!root) {
       throw Exception("no abstract syntax tree has been generated");
    }
    run(root, loader, script_name, /* pattern= */ nullptr, /* count = */ 0,
-      parentheses, std::cout, extra_bindings, argc, argv);
+      /* unique = */ false, /* duplicates = */ nullptr, parentheses,
+      std::cout, extra_bindings, argc, argv);
 }
 
 /* free-standing execution order where no AST is preloaded */
@@ -281,7 +402,8 @@ void run(int& argc, char**& argv,
    /* generate AST */
    NodePtr root;
    run(root, loader, script_name, /* pattern= */ nullptr, /* count = */ 0,
-      parentheses, std::cout, extra_bindings, argc, argv);
+      /* unique = */ false, /* duplicates = */ nullptr, parentheses,
+      std::cout, extra_bindings, argc, argv);
 }
 
 void run(int& argc, char**& argv, SyntaxTreeGenerator& astgen,
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -42,6 +42,32 @@ void run(NodePtr root,
       const Operator& parentheses,
       std::ostream& out);
 
+/* like above but if unique is true, mutations that put
+   a subtree at a position where a structurally equal subtree
+   has been put by a previously generated mutation are skipped */
+void run(NodePtr root,
+      const char* rules_filename, const char* pattern,
+      std::size_t count, bool unique,
+      const Operator& parentheses,
+      std::ostream& out,
+      BindingsPtr extra_bindings);
+
+/* like above but the number of skipped duplicates
+   is stored in duplicates */
+void run(NodePtr root,
+      const char* rules_filename, const char* pattern,
+      std::size_t count, bool unique,
+      const Operator& parentheses,
+      std::ostream& out,
+      BindingsPtr extra_bindings,
+      std::size_t& duplicates);
+
+/* standard execution order; if astgen is a streaming generator,
+   and neither state machines nor transformations are to be executed,
+   and the attribution rules neither apply to the root nor depend on it
+   within their contexts, the attribution rules are executed for each
+   top-level subtree individually which is released afterwards;
+   main is then invoked with a root that has no operands */
 void run(int& argc, char**& argv, SyntaxTreeGenerator& astgen,
       Loader& loader, const Operator& parentheses);
 
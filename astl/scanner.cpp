@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010, 2019 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -35,8 +35,10 @@ const unsigned int TAB_STOP = 8;
 // constructor ===============================================================
 
 Scanner::Scanner(std::istream& in, const std::string& input_name) :
-      in(in), input_name(input_name), ch(0), codepoint(0),
-      eof_seen(false), eof(false), tokenstr(nullptr) {
+      in(in), input_name(input_name),
+      buffer(new char[buffer_size]),
+      bufpos(buffer.get()), bufend(buffer.get()),
+      ch(0), codepoint(0), eof_seen(false), eof(false), tokenstr(nullptr) {
    pos.initialize(&this->input_name);
    next_ch(); next_codepoint();
    if (!eof && codepoint == '#') {
@@ -57,7 +59,8 @@ int Scanner::get_token(semantic_type& yylval, location& yylloc) {
    int token;
    do {
       if (token_buffer.size() > 0) {
-	 TokenItem t = token_buffer.front(); token_buffer.pop_front();
+	 TokenItem t = std::move(token_buffer.front());
+	 token_buffer.pop_front();
 	 yylval = t.yylval; yylloc = t.yylloc;
 	 return t.token;
       }
@@ -73,6 +76,7 @@ bool Scanner::get_next_token(semantic_type& yylval,
       if (eof) {
 	 break;
       } else if (is_whitespace(codepoint)) {
+	 skip_ascii([](char c) { return c == ' '; });
 	 next_codepoint();
       } else {
 	 break;
@@ -97,6 +101,7 @@ bool Scanner::get_next_token(semantic_type& yylval,
 	 return false; // fetch tokens from the token buffer
       } else {
 	 while (is_letter(codepoint) || is_digit(codepoint)) {
+	    skip_ascii([](char c) { return is_letter(c) || is_digit(c); });
 	    next_codepoint();
 	 }
 	 int keyword_token;
@@ -114,6 +119,7 @@ bool Scanner::get_next_token(semantic_type& yylval,
       }
    } else if (is_digit(codepoint)) {
       tokenstr = std::make_unique<std::string>();
+      skip_ascii([](char c) { return is_digit(c); });
       next_codepoint();
       while (is_digit(codepoint)) {
 	 next_codepoint();
@@ -131,6 +137,7 @@ bool Scanner::get_next_token(semantic_type& yylval,
 	    if (codepoint == '/') {
 	       /* single-line comment */
 	       while (!eof && codepoint != '\n') {
+		  skip_ascii([](char) { return true; });
 		  next_codepoint();
 	       }
 	       if (eof) {
@@ -142,6 +149,9 @@ bool Scanner::get_next_token(semantic_type& yylval,
 	       bool star = false;
 	       while (!eof && (!star || codepoint != '/')) {
 		  star = codepoint == '*';
+		  if (!star) {
+		     skip_ascii([](char c) { return c != '*'; });
+		  }
 		  next_codepoint();
 	       }
 	       if (eof) {
@@ -292,8 +302,7 @@ bool Scanner::get_next_token(semantic_type& yylval,
 // private methods ===========================================================
 
 void Scanner::push_token(int token, semantic_type yylval, location yylloc) {
-   TokenItem t = {token, yylval, yylloc};
-   token_buffer.push_back(t);
+   token_buffer.push_back(TokenItem{token, std::move(yylval), yylloc});
 }
 
 /* scan esacpe sequence within string or program text literals */
@@ -604,11 +613,18 @@ void Scanner::next_ch() {
    if (eof_seen) {
       ch = 0; return;
    }
-   char c;
-   if (!in.get(c)) {
-      eof_seen = true; ch = 0; return;
+   if (bufpos == bufend) {
+      std::streamsize count = 0;
+      if (in) {
+	 count = in.rdbuf()->sgetn(buffer.get(), buffer_size);
+      }
+      if (count <= 0) {
+	 in.setstate(std::ios::eofbit);
+	 eof_seen = true; ch = 0; return;
+      }
+      bufpos = buffer.get(); bufend = bufpos + count;
    }
-   ch = c;
+   ch = *bufpos++;
 }
 
 void Scanner::next_codepoint() {
@@ -665,6 +681,45 @@ void Scanner::next_codepoint() {
    }
 }
 
+/*
+   Fast path for sequences of plain ASCII characters which is
+   equivalent to invoking next_codepoint() as long as the next
+   codepoint, i.e. ch, satisfies pred, is neither a tab, newline,
+   nor a null byte, and is followed by another byte within
+   the buffer. Afterwards, next_codepoint() is to be invoked
+   at least once to consume the codepoint left behind.
+*/
+template<typename Predicate>
+void Scanner::skip_ascii(Predicate pred) {
+   auto plain = [&pred](unsigned char c) {
+      return c < 0x80 && c != '\n' && c != '\t' && c != 0 && pred(c);
+   };
+   if (eof_seen || bufpos == bufend || !plain(ch)) return;
+   /* ch is the first codepoint to be skipped, further
+      codepoints are taken from bufpos[0], bufpos[1], ... */
+   std::size_t count = 1;
+   while (bufpos + count < bufend && plain(bufpos[count-1])) {
+      ++count;
+   }
+   if (tokenstr != nullptr) {
+      add_codepoint(*tokenstr, codepoint);
+      if (count > 1) {
+	 tokenstr->push_back(ch);
+	 tokenstr->append(bufpos, count - 2);
+      }
+   }
+   if (count == 1) {
+      tokenloc.end = oldpos;
+      codepoint = ch;
+   } else {
+      tokenloc.end = pos; tokenloc.end.columns(count - 2);
+      codepoint = (unsigned char) bufpos[count-2];
+   }
+   ch = bufpos[count-1]; bufpos += count;
+   oldpos = pos; oldpos.columns(count - 1);
+   pos.columns(count);
+}
+
 void Scanner::error(char const* msg) {
    yyerror(&tokenloc, msg);
 }
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,8 +19,9 @@
 #ifndef ASTL_SCANNER_H
 #define ASTL_SCANNER_H
 
+#include <cstddef>
+#include <deque>
 #include <iostream>
-#include <list>
 #include <memory>
 #include <astl/location.hpp>
 #include <astl/parser.hpp>
@@ -39,6 +40,11 @@ namespace Astl {
       private:
 	 std::istream& in;
 	 std::string input_name;
+	 /* the input is read in blocks from the stream buffer */
+	 static constexpr std::size_t buffer_size = 65536;
+	 std::unique_ptr<char[]> buffer;
+	 const char* bufpos; // next byte to be delivered by next_ch()
+	 const char* bufend;
 	 unsigned char ch;
 	 char32_t codepoint; // Unicode codepoint, delivered by next_codepoint()
 	 bool eof_seen; // set by next_ch()
@@ -52,11 +58,12 @@ namespace Astl {
 	    semantic_type yylval;
 	    location yylloc;
 	 };
-	 std::list<TokenItem> token_buffer;
+	 std::deque<TokenItem> token_buffer;
 
 	 // private mutators
 	 void next_ch();
 	 void next_codepoint();
+	 template<typename Predicate> void skip_ascii(Predicate pred);
 	 void error(char const* msg);
 	 char32_t scan_escape_sequence();
 	 void scan_text();
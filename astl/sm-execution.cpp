@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,10 +16,20 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <atomic>
+#include <climits>
 #include <cstdlib>
+#include <deque>
+#include <exception>
 #include <list>
+#include <map>
 #include <memory>
+#include <ostream>
+#include <set>
 #include <stack>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <astl/attribute.hpp>
 #include <astl/bindings.hpp>
 #include <astl/execution.hpp>
@@ -37,6 +47,61 @@ struct CacheKey;
 struct CacheEntry;
 typedef std::map<CacheKey, CacheEntry> Cache;
 
+/*
+   Bit matrix indexed by control flow node id and state;
+   as node ids are dense, the rows are kept in contiguous
+   pages of page_rows rows which are allocated on first use;
+   the page table is presized from the number of node ids
+   but extended if nodes are created during the execution
+*/
+class StateTable {
+   public:
+      StateTable(std::size_t nof_ids, std::size_t nof_states) :
+	    nof_states(nof_states),
+	    words_per_row((nof_states + word_bits - 1) / word_bits),
+	    pages((nof_ids + page_rows - 1) / page_rows) {
+      }
+      bool test(std::size_t id, std::size_t state) const {
+	 std::size_t page = id / page_rows;
+	 if (page >= pages.size() || !pages[page]) return false;
+	 return (word(id, state) & bit(state)) != 0;
+      }
+      /* returns true if the bit has not been set before */
+      bool set(std::size_t id, std::size_t state) {
+	 assert(state < nof_states);
+	 std::size_t page = id / page_rows;
+	 if (page >= pages.size()) {
+	    pages.resize(page + 1);
+	 }
+	 if (!pages[page]) {
+	    pages[page] = std::make_unique<Word[]>(words_per_row * page_rows);
+	 }
+	 Word& w = word(id, state);
+	 if (w & bit(state)) return false;
+	 w |= bit(state);
+	 return true;
+      }
+      void reset(std::size_t id, std::size_t state) {
+	 assert(test(id, state));
+	 word(id, state) &= ~bit(state);
+      }
+   private:
+      typedef unsigned long Word;
+      static constexpr std::size_t word_bits = sizeof(Word) * CHAR_BIT;
+      static constexpr std::size_t page_rows = 64;
+      std::size_t nof_states;
+      std::size_t words_per_row;
+      std::vector<std::unique_ptr<Word[]>> pages;
+
+      Word& word(std::size_t id, std::size_t state) const {
+	 return pages[id / page_rows][(id % page_rows) * words_per_row +
+	    state / word_bits];
+      }
+      static Word bit(std::size_t state) {
+	 return Word(1) << (state % word_bits);
+      }
+};
+
 /*
    Shared data structure for a given state machine that has been
    created at a particular control flow node;
@@ -47,37 +112,23 @@ typedef std::map<CacheKey, CacheEntry> Cache;
     - the shared variables of a state machine
 */
 struct Instance {
-   Instance(StateMachinePtr sm_param, BindingsPtr bindings_param) :
-      sm(sm_param), bindings(bindings_param) {
+   Instance(StateMachinePtr sm_param, BindingsPtr bindings_param,
+	    std::size_t nof_ids) :
+      sm(sm_param), bindings(bindings_param),
+      states(nof_ids, sm->get_nofxstates()) {
    }
    bool visited(unsigned int id, unsigned int state) const {
-      Map::const_iterator it = states.find(id);
-      if (it == states.end()) return false;
-      const StateSet& set(it->second);
-      if (state >= set.size()) return false;
-      return set.test(state);
+      return states.test(id, state);
    }
    bool visit(unsigned int id, unsigned int state) {
-      StateSet stateset(sm->get_nofxstates()); stateset.set(state);
-      std::pair<Map::iterator, bool> result =
-	 states.insert(make_pair(id, stateset));
-      if (result.second) {
-	 return true;
-      }
-      StateSet& set(result.first->second);
-      if (set.test(state)) return false;
-      set.set(state);
-      return true;
+      return states.set(id, state);
    }
    void retract(unsigned int id, unsigned int state) {
-      Map::iterator it = states.find(id);
-      assert(it != states.end());
-      it->second.reset(state);
+      states.reset(id, state);
    }
    StateMachinePtr sm;
    BindingsPtr bindings; // shared bindings
-   typedef std::map<unsigned int, StateSet> Map;
-   Map states; // set of states per cfg node
+   StateTable states; // set of states per cfg node
    // cache data structure, used by the cache action
    // this is required to support interprocedural paths for
    // global state machines
@@ -90,11 +141,19 @@ struct Instance {
     - the current state of a state machine,
     - the private variables, and
     - the stack used for the interprocedural analysis
+
+   Copies of an instance thread share their private bindings
+   until one of them is about to modify them (copy on write);
+   all copies that share the private bindings share the same
+   owner object such that its use count tells whether the
+   private bindings are shared.
 */
 struct InstanceThread {
+   struct BindingsOwner {};
    InstanceThread(InstancePtr smi_param) :
 	 smi(smi_param), state(0),
 	 bindings(smi->sm->add_private_bindings(smi->bindings)),
+	 owner(std::make_shared<BindingsOwner>()),
 	 close_id(0) {
    }
    void fork_bindings() {
@@ -105,6 +164,11 @@ struct InstanceThread {
       // and update local functions
       smi->sm->update_function_bindings(new_bindings);
       bindings = new_bindings;
+      owner = std::make_shared<BindingsOwner>();
+   }
+   /* to be invoked before the private bindings are possibly modified */
+   void unshare_bindings() {
+      if (owner.use_count() > 1) fork_bindings();
    }
    unsigned int combined_state() const {
       if (stack.size() > 0) {
@@ -126,13 +190,16 @@ struct InstanceThread {
    InstancePtr smi;
    unsigned int state; // current state
    BindingsPtr bindings; // private bindings
+   std::shared_ptr<BindingsOwner> owner; // of the private bindings
    // used by the cache action:
    typedef struct {
       FlowGraphNodePtr return_node;
       unsigned int entry_id;
       unsigned int entry_state;
    } StackEntry;
-   std::stack<StackEntry> stack; // used by cache action
+   // used by cache action;
+   // a vector is used as it is cheaper to create and move than a deque
+   std::stack<StackEntry, std::vector<StackEntry>> stack;
    unsigned int close_id; // used for the detection of an endless recursion
 };
 
@@ -159,16 +226,25 @@ struct CacheEntry {
    std::list<CacheInstance> instances;
 };
 
+typedef std::vector<InstanceThread> InstanceThreads;
+
 /*
-   Collection of instance threads that share a location
+   Collection of instance threads that share a location;
+   threads are moved but never copied
 */
 struct Thread {
-   typedef std::list<InstanceThread>::iterator Iterator;
-   std::list<InstanceThread> instances;
+   Thread(FlowGraphNodePtr node, InstanceThreads&& instances) :
+	 instances(std::move(instances)), node(node) {
+   }
+   Thread(Thread&& other) = default;
+   Thread& operator=(Thread&& other) = default;
+   Thread(const Thread& other) = delete;
+   Thread& operator=(const Thread& other) = delete;
+   InstanceThreads instances;
    FlowGraphNodePtr node;
 };
 
-typedef std::list<Thread> ThreadList;
+typedef std::deque<Thread> ThreadList;
 
 /*
    Global data structures including
@@ -178,19 +254,13 @@ typedef std::list<Thread> ThreadList;
       at a particular control flow node
 */
 struct ExecutionContext {
-   ExecutionContext() : next_id(1) {
+   ExecutionContext(std::size_t nof_ids, unsigned int nof_sms) :
+	 prioritized(false), nof_priorities(0), nof_ids(nof_ids),
+	 created(nof_ids, nof_sms), nof_sms(nof_sms), next_id(1),
+	 instance_visits(0), dropped(0) {
    }
    bool creatable(unsigned int node_id, unsigned int sm_id) {
-      StateMachineSet smset(nof_sms); smset.set(sm_id);
-      std::pair<Map::iterator, bool> result =
-	 created.insert(make_pair(node_id, smset));
-      if (result.second) {
-	 return true;
-      }
-      StateMachineSet& set(result.first->second);
-      if (set.test(sm_id)) return false;
-      set.set(sm_id);
-      return true;
+      return created.set(node_id, sm_id);
    }
    void set_close_id(InstanceThread& it) {
       if (!it.close_id) it.close_id = next_id++;
@@ -202,25 +272,137 @@ struct ExecutionContext {
    void remove_candidate_for_close(InstanceThread& it) {
       candidates_for_close.erase(it.close_id);
    }
+   /* the storage of instance thread vectors is recycled */
+   InstanceThreads acquire() {
+      if (pool.size() == 0) return InstanceThreads();
+      InstanceThreads instances(std::move(pool.back()));
+      pool.pop_back();
+      return instances;
+   }
+   void release(InstanceThreads&& instances) {
+      if (instances.capacity() == 0) return;
+      instances.clear();
+      pool.push_back(std::move(instances));
+   }
+   /*
+      Pending threads: by default, the threads for the successors
+      of a node are processed next (depth first) while threads forked
+      off by the cache action are appended. If prioritized, pending
+      threads are ordered by the reverse postorder of their nodes
+      and threads for the same node are coalesced.
+   */
+   void prioritize(const std::vector<FlowGraphNodePtr>& order) {
+      prioritized = true;
+      for (auto& node: order) {
+	 get_priority(node);
+      }
+   }
+   void schedule(Thread&& thread, bool front) {
+      if (prioritized) {
+	 std::size_t priority = get_priority(thread.node);
+	 auto it = pending.find(priority);
+	 if (it == pending.end()) {
+	    pending.insert(std::make_pair(priority, std::move(thread)));
+	 } else {
+	    for (auto& instance: thread.instances) {
+	       it->second.instances.push_back(std::move(instance));
+	    }
+	    release(std::move(thread.instances));
+	 }
+      } else if (front) {
+	 threads.push_front(std::move(thread));
+      } else {
+	 threads.push_back(std::move(thread));
+      }
+   }
+   bool idle() const {
+      return threads.size() == 0 && pending.size() == 0;
+   }
+   Thread next() {
+      if (prioritized) {
+	 Thread thread(std::move(pending.begin()->second));
+	 pending.erase(pending.begin());
+	 return thread;
+      }
+      Thread thread(std::move(threads.front())); threads.pop_front();
+      return thread;
+   }
+   /* nodes unknown to the reverse postorder are appended */
+   std::size_t get_priority(const FlowGraphNodePtr& node) {
+      std::size_t id = node->get_id();
+      if (id >= priorities.size()) priorities.resize(id + 1);
+      if (!priorities[id]) priorities[id] = ++nof_priorities;
+      return priorities[id];
+   }
+   /* the labels of links are kept by their interned ids (see
+      label_by_name) such that they remain accessible while rules
+      add further links to a node; labels without id are copied */
+   const std::string& get_label(const FlowGraphNode::Link& link) {
+      if (link.label_index == 0) {
+	 unindexed_label = link.label;
+	 return unindexed_label;
+      }
+      if (link.label_index >= labels.size()) {
+	 labels.resize(link.label_index + 1);
+      }
+      std::string& label = labels[link.label_index];
+      if (label.empty()) label = link.label;
+      return label;
+   }
+   /* statistics */
+   void count_visit(const Thread& thread) {
+      std::size_t id = thread.node->get_id();
+      if (id >= visits.size()) visits.resize(id + 1);
+      ++visits[id];
+      instance_visits += thread.instances.size();
+   }
+   void print_statistics(std::ostream& out) const {
+      std::size_t nof_nodes = 0, nof_visits = 0, max_visits = 0;
+      for (auto count: visits) {
+	 if (!count) continue;
+	 ++nof_nodes; nof_visits += count;
+	 if (count > max_visits) max_visits = count;
+      }
+      out << "state machines: " << nof_visits << " visit(s) of "
+	 << nof_nodes << " node(s), at most " << max_visits
+	 << " per node, " << instance_visits << " instance thread(s), "
+	 << dropped << " of them dropped as already visited" << std::endl;
+   }
    void run_close_handlers() {
       for (InstanceThreadMap::iterator it = candidates_for_close.begin();
 	    it != candidates_for_close.end();
 	    ++it) {
+	 // current_state is defined in a scope of its own such that
+	 // private bindings need to be copied only if they are modified
+	 if (it->second.smi->sm->close_handlers_modify_private_bindings()) {
+	    it->second.unshare_bindings();
+	 }
 	 it->second.smi->sm->run_close_handlers(it->second.state,
-	       it->second.bindings);
+	       std::make_shared<Bindings>(it->second.bindings));
       }
       candidates_for_close.clear();
    }
    BindingsPtr bindings;
    ThreadList threads;
+   bool prioritized;
+   std::map<std::size_t, Thread> pending; // by priority, if prioritized
+   std::vector<std::size_t> priorities; // by node id, 0 if unknown
+   std::size_t nof_priorities;
+   std::vector<std::string> labels; // by label index
+   std::string unindexed_label;
+   std::vector<InstanceThreads> pool;
+   std::size_t nof_ids; // initial upper bound of the cfg node ids
    // which sms have been created/tested at a particular cfg node?
-   typedef std::map<unsigned int, StateMachineSet> Map;
-   Map created;
+   StateTable created;
    unsigned int nof_sms;
    // which instance threads need to be closed at the end?
    typedef std::map<unsigned int, InstanceThread> InstanceThreadMap;
    unsigned int next_id;
    InstanceThreadMap candidates_for_close;
+   // visit statistics
+   std::vector<std::size_t> visits; // by node id
+   std::size_t instance_visits;
+   std::size_t dropped;
 };
 
 static FlowGraphNodePtr get_root(BindingsPtr bindings) {
@@ -238,41 +420,35 @@ static FlowGraphNodePtr get_root(BindingsPtr bindings) {
 
 static InstanceThread create_instance(ExecutionContext& ec, StateMachinePtr sm,
       FlowGraphNodePtr start) {
-   InstancePtr ip = std::make_shared<Instance>(sm, sm->get_shared_bindings());
-   StateMachineSet smset(ec.nof_sms);
-   smset.set(sm->get_id());
-   std::pair<ExecutionContext::Map::iterator, bool> result =
-      ec.created.insert(make_pair(start->get_id(), smset));
-   if (!result.second) {
-      result.first->second.set(sm->get_id());
-   }
+   InstancePtr ip = std::make_shared<Instance>(sm, sm->get_shared_bindings(),
+      ec.nof_ids);
+   ec.created.set(start->get_id(), sm->get_id());
    // StateSet states(sm->get_nofstates()); states.set(0);
    // ip->states[start->get_id()] = states;
    return InstanceThread(ip);
 }
 
+/*
+   structural tests of the tree expression of a rule, if any,
+   which can be done without bindings
+*/
+static bool structurally_matches(StateMachineRulePtr smr, const NodePtr& ast) {
+   if (!smr->tree_expr_defined()) return true;
+   if (!ast) return false;
+   if (ast->is_leaf()) return false;
+   Arity arity = smr->get_arity();
+   if (arity.fixed && arity.arity != ast->size()) return false;
+   return smr->get_opset()->includes(ast->get_op());
+}
+
 void check_creation(ExecutionContext& ec, StateMachinePtr sm,
-	    FlowGraphNodePtr fgnode, std::list<InstanceThread>& instances) {
-   unsigned int node_type = fgnode->get_type_number();
+	    FlowGraphNodePtr fgnode, InstanceThreads& instances) {
    NodePtr ast = fgnode->get_node();
-   for (StateMachine::Iterator it = sm->get_creating_rules_begin();
-	 it != sm->get_creating_rules_end(); ++it) {
-      StateMachineRulePtr smr = *it;
-      const NodeTypeSet& ntset = smr->get_nodetypes();
-      // skip rule if the node type does not match
-      if (ntset.size() > 0 &&
-	    (node_type >= ntset.size() || !ntset.test(node_type))) {
-	 continue;
-      }
+   for (auto& smr: sm->get_creating_rules(fgnode->get_type_number())) {
+      if (!structurally_matches(smr, ast)) continue;
       // check tree expression, if any
       BindingsPtr bindings = std::make_shared<Bindings>(ec.bindings);
       if (smr->tree_expr_defined()) {
-	 if (!ast) continue;
-	 if (ast->is_leaf()) continue;
-	 Arity arity = smr->get_arity();
-	 if (arity.fixed && arity.arity != ast->size()) continue;
-	 std::string opname(ast->get_op().get_name());
-	 if (!smr->get_opset()->includes(opname)) continue;
 	 NodePtr tree_expr = smr->get_tree_expression();
 	 if (!matches(ast, tree_expr, bindings, ast->get_context())) continue;
       }
@@ -283,12 +459,11 @@ void check_creation(ExecutionContext& ec, StateMachinePtr sm,
 	 Expression cond(nodecond, bindings);
 	 if (!cond.convert_to_bool()) continue;
       }
-      InstanceThread ithread = create_instance(ec, sm, fgnode);
-      instances.push_back(ithread);
+      instances.push_back(create_instance(ec, sm, fgnode));
       NodePtr block = smr->get_block();
       if (block) {
 	 BindingsPtr local_bindings =
-	    std::make_shared<Bindings>(ithread.bindings);
+	    std::make_shared<Bindings>(instances.back().bindings);
 	 local_bindings->merge(bindings);
 	 execute(block, local_bindings);
       }
@@ -314,13 +489,12 @@ void check_cache(ExecutionContext& ec, InstanceThread& t,
    for (std::list<CacheInstance>::const_iterator iit =
 	 it->second.instances.begin();
 	 iit != it->second.instances.end(); ++iit) {
-      Thread nthread; nthread.node = iit->fgnode;
+      Thread nthread(iit->fgnode, ec.acquire());
       InstanceThread newt = iit->instance;
-      newt.fork_bindings();
       newt.state = t.state;
       if (newt.close_id) ec.remove_candidate_for_close(newt);
-      nthread.instances.push_back(newt);
-      ec.threads.push_back(nthread);
+      nthread.instances.push_back(std::move(newt));
+      ec.schedule(std::move(nthread), false);
    }
 }
 
@@ -329,60 +503,48 @@ bool execute_rules(ExecutionContext& ec, InstanceThread& t,
       FlowGraphNodePtr fgnode, unsigned int successor_index) {
    InstancePtr smi = t.smi;
    StateMachinePtr sm = smi->sm;
-   unsigned int node_type = fgnode->get_type_number();
    NodePtr ast = fgnode->get_node();
    int newstate = t.state;
    bool cut = false;
-   for (StateMachine::Iterator it = sm->get_rules_begin();
-	 !cut && it != sm->get_rules_end(); ++it) {
-      StateMachineRulePtr smr = *it;
-      const NodeTypeSet& ntset = smr->get_nodetypes();
-      // skip rule if the node type does not match
-      if (ntset.size() > 0 &&
-	    (node_type >= ntset.size() || !ntset.test(node_type))) {
-	 continue;
+   // the bound attributes are shared by all rules and
+   // allocated when the first rule passes the structural tests
+   AttributePtr node_at, state_at, label_at;
+   const StateMachine::DispatchList& dispatch_list =
+      sm->get_dispatch_list(fgnode->get_type_number(), label_index, t.state);
+   for (auto dit = dispatch_list.begin();
+	 !cut && dit != dispatch_list.end(); ++dit) {
+      StateMachineRulePtr smr = dit->rule;
+      if (!structurally_matches(smr, ast)) continue;
+      // copy private bindings, if shared and possibly modified
+      if (sm->modifies_private_bindings(smr)) {
+	 t.unshare_bindings();
       }
       // check tree expression, if any
       BindingsPtr bindings = std::make_shared<Bindings>(t.bindings);
       if (smr->tree_expr_defined()) {
-	 if (!ast) continue;
-	 if (ast->is_leaf()) continue;
-	 Arity arity = smr->get_arity();
-	 if (arity.fixed && arity.arity != ast->size()) continue;
-	 std::string opname(ast->get_op().get_name());
-	 if (!smr->get_opset()->includes(opname)) continue;
 	 NodePtr tree_expr = smr->get_tree_expression();
 	 if (!matches(ast, tree_expr, bindings, ast->get_context())) continue;
 	 bindings = std::make_shared<Bindings>(bindings);
       }
       // check node condition, if any
+      if (!node_at) {
+	 node_at = std::make_shared<Attribute>(fgnode);
+	 state_at = std::make_shared<Attribute>(
+	    sm->get_state_by_number(t.state));
+	 label_at = std::make_shared<Attribute>(label_text);
+      }
       NodePtr nodecond = smr->get_node_condition();
-      bindings->define("node", std::make_shared<Attribute>(fgnode));
-      bindings->define("current_state",
-	 std::make_shared<Attribute>(sm->get_state_by_number(t.state)));
-      bindings->define("label", std::make_shared<Attribute>(label_text));
+      bindings->define("node", node_at);
+      bindings->define("current_state", state_at);
+      bindings->define("label", label_at);
       if (nodecond) {
 	 Expression cond(nodecond, bindings);
 	 if (!cond.convert_to_bool()) continue;
       }
-      // check individual alternatives
-      for (StateMachineRule::AlternativesIterator ait =
-	    smr->get_alternatives_begin();
-	    !cut && ait != smr->get_alternatives_end(); ++ait) {
-	 StateMachineRuleAlternativePtr alt = *ait;
-	 // check if one of the given labels matches
-	 const LabelSet& labels(alt->get_labels());
-	 if (labels.size() > 0 &&
-	       (label_index >= labels.size() || !labels.test(label_index))) {
-	    continue;
-	 }
-	 // check if one of the given states matches
-	 const StateSet& states(alt->get_states());
-	 if (states.size() > 0 &&
-	       (t.state >= states.size() || !states.test(t.state))) {
-	    continue;
-	 }
-	 // execute it
+      // execute the alternatives that match label and state
+      for (auto ait = dit->alternatives.begin();
+	    !cut && ait != dit->alternatives.end(); ++ait) {
+	 const StateMachineRuleAlternativePtr& alt = *ait;
 	 if (alt->get_newstate() >= 0) {
 	    newstate = alt->get_newstate();
 	 }
@@ -419,19 +581,20 @@ bool execute_rules(ExecutionContext& ec, InstanceThread& t,
 		     if (it != smi->cache.end()) {
 			// take a shortcut to the rtn node,
 			// using all the cached states
-			Thread nthread; nthread.node = fgnode;
-			StateSet states = it->second.states;
+			Thread nthread(fgnode, ec.acquire());
+			const StateSet& states = it->second.states;
 			unsigned int state = states.find_first();
 			while (state < states.size()) {
 			   InstanceThread newt = t;
-			   newt.fork_bindings();
 			   newt.state = state;
-			   nthread.instances.push_back(newt);
+			   nthread.instances.push_back(std::move(newt));
 			   state = states.find_next(state);
 			}
 			if (nthread.instances.size() > 0) {
-			   ec.threads.push_back(nthread);
+			   ec.schedule(std::move(nthread), false);
 			   forked = true;
+			} else {
+			   ec.release(std::move(nthread.instances));
 			}
 			// add this instance to the list such that
 			// we are able to fork off further instances
@@ -473,6 +636,367 @@ bool execute_rules(ExecutionContext& ec, InstanceThread& t,
    return !cut;
 }
 
+/*
+   Path-independent state machines (see StateMachine::is_path_independent)
+   are run as a monotone dataflow problem: each control flow node gets
+   the set of states it is reached with, and each link has a transfer
+   function that maps sets of states to sets of states. The states are
+   propagated in reverse postorder until the fixpoint is reached.
+   Afterwards the blocks and close handlers are executed once for each
+   node and reached state, like the regular execution would have done,
+   albeit in a different order.
+*/
+
+/*
+   state of a state machine after passing the given link
+   or -1 if the rules cut it; no blocks are executed
+*/
+static int transition(InstanceThread& t, FlowGraphNodePtr fgnode,
+      const std::string& label_text, unsigned int label_index, int state) {
+   StateMachinePtr sm = t.smi->sm;
+   NodePtr ast = fgnode->get_node();
+   int newstate = state;
+   for (auto& dispatch: sm->get_dispatch_list(fgnode->get_type_number(),
+	 label_index, state)) {
+      StateMachineRulePtr smr = dispatch.rule;
+      if (!structurally_matches(smr, ast)) continue;
+      NodePtr nodecond = smr->get_node_condition();
+      if (smr->tree_expr_defined() || nodecond) {
+	 BindingsPtr bindings = std::make_shared<Bindings>(t.bindings);
+	 if (smr->tree_expr_defined()) {
+	    NodePtr tree_expr = smr->get_tree_expression();
+	    if (!matches(ast, tree_expr, bindings, ast->get_context())) {
+	       continue;
+	    }
+	    bindings = std::make_shared<Bindings>(bindings);
+	 }
+	 if (nodecond) {
+	    bindings->define("node", std::make_shared<Attribute>(fgnode));
+	    bindings->define("current_state",
+	       std::make_shared<Attribute>(sm->get_state_by_number(state)));
+	    bindings->define("label",
+	       std::make_shared<Attribute>(label_text));
+	    Expression cond(nodecond, bindings);
+	    if (!cond.convert_to_bool()) continue;
+	 }
+      }
+      for (auto& alt: dispatch.alternatives) {
+	 if (alt->get_newstate() >= 0) {
+	    newstate = alt->get_newstate();
+	 }
+	 switch (alt->get_action()) {
+	    case StateMachineRuleAlternative::close:
+	    case StateMachineRuleAlternative::cut:
+	       return -1;
+	    case StateMachineRuleAlternative::null:
+	       break;
+	    default:
+	       assert(false); std::abort();
+	 }
+      }
+   }
+   return newstate;
+}
+
+/*
+   transfer function of a link, represented by the set of source
+   states for each target state; transitions are computed for
+   the states that have been seen so far
+*/
+struct Transfer {
+   Transfer(std::size_t nofstates) :
+	 known(nofstates), sources(nofstates, StateSet(nofstates)) {
+   }
+   void apply(InstanceThread& t, FlowGraphNodePtr fgnode,
+	 const std::string& label_text, unsigned int label_index,
+	 const StateSet& in, StateSet& out) {
+      if (!in.is_subset_of(known)) {
+	 StateSet unknown = in - known;
+	 for (std::size_t state = unknown.find_first();
+	       state < unknown.size(); state = unknown.find_next(state)) {
+	    int target = transition(t, fgnode, label_text, label_index, state);
+	    if (target >= 0) sources[target].set(state);
+	 }
+	 known |= unknown;
+      }
+      for (std::size_t target = 0; target < sources.size(); ++target) {
+	 if (in.intersects(sources[target])) out.set(target);
+      }
+   }
+   /* compute the transitions for all states in advance; states
+      for which the conditions fail are left to apply() such that
+      errors are reported only if these states are reached */
+   bool precompute(InstanceThread& t, FlowGraphNodePtr fgnode,
+	 const std::string& label_text, unsigned int label_index) {
+      bool ok = true;
+      for (std::size_t state = 0; state < known.size(); ++state) {
+	 if (known.test(state)) continue;
+	 try {
+	    int target = transition(t, fgnode,
+	       label_text, label_index, state);
+	    if (target >= 0) sources[target].set(state);
+	    known.set(state);
+	 } catch (Exception&) {
+	    ok = false;
+	 }
+      }
+      return ok;
+   }
+   StateSet known;
+   std::vector<StateSet> sources;
+};
+typedef std::shared_ptr<Transfer> TransferPtr;
+
+/* do the rules for the given link in the given state execute anything? */
+static bool reports(StateMachinePtr sm, FlowGraphNodePtr fgnode,
+      unsigned int label_index, int state) {
+   for (auto& dispatch: sm->get_dispatch_list(fgnode->get_type_number(),
+	 label_index, state)) {
+      for (auto& alt: dispatch.alternatives) {
+	 if (alt->get_block() ||
+	       alt->get_action() == StateMachineRuleAlternative::close) {
+	    return true;
+	 }
+      }
+   }
+   return false;
+}
+
+/*
+   control flow graph in reverse postorder where
+   the links refer to the positions of their successors
+*/
+struct DataflowGraph {
+   struct Link {
+      std::size_t successor; // position
+      std::string label_text;
+      unsigned int label_index;
+   };
+   DataflowGraph(FlowGraphNodePtr root) {
+      reverse_postorder(root, nodes);
+      for (std::size_t index = 0; index < nodes.size(); ++index) {
+	 std::size_t id = nodes[index]->get_id();
+	 if (id >= position.size()) position.resize(id + 1);
+	 position[id] = index;
+      }
+      links.resize(nodes.size());
+      for (std::size_t index = 0; index < nodes.size(); ++index) {
+	 FlowGraphNodePtr node = nodes[index];
+	 for (FlowGraphNode::Iterator it = node->begin_links();
+	       it != node->end_links(); ++it) {
+	    links[index].push_back(Link{position[it->node->get_id()],
+	       it->label, (unsigned int) it->label_index});
+	 }
+      }
+   }
+   std::vector<FlowGraphNodePtr> nodes;
+   std::vector<std::size_t> position; // indexed by node id
+   std::vector<std::vector<Link>> links;
+};
+
+/*
+   transfer functions of all links of the graph for one
+   path-independent state machine; as these state machines have
+   no variables, the transfer functions are shared by all instances;
+   they are computed in advance for all states such that the
+   instances can be solved concurrently
+*/
+struct TransferTable {
+   TransferTable(StateMachinePtr sm, const DataflowGraph& graph) :
+	 graph(graph),
+	 t(std::make_shared<Instance>(sm, sm->get_shared_bindings(), 0)),
+	 complete(true) {
+      /* without any conditions the transfer functions depend
+	 on the node type and the label only */
+      bool by_type_only = true;
+      for (StateMachine::Iterator it = sm->get_rules_begin();
+	    it != sm->get_rules_end(); ++it) {
+	 if ((*it)->tree_expr_defined() || (*it)->get_node_condition()) {
+	    by_type_only = false; break;
+	 }
+      }
+      std::size_t nofstates = sm->get_nofstates();
+      std::map<std::pair<std::size_t, unsigned int>, TransferPtr> by_type;
+      transfers.resize(graph.nodes.size());
+      for (std::size_t index = 0; index < graph.nodes.size(); ++index) {
+	 FlowGraphNodePtr node = graph.nodes[index];
+	 for (auto& link: graph.links[index]) {
+	    TransferPtr transfer;
+	    if (by_type_only) {
+	       TransferPtr& shared = by_type[std::make_pair(
+		  node->get_type_number(), link.label_index)];
+	       if (!shared) {
+		  shared = std::make_shared<Transfer>(nofstates);
+		  if (!shared->precompute(t, node,
+			link.label_text, link.label_index)) {
+		     complete = false;
+		  }
+	       }
+	       transfer = shared;
+	    } else {
+	       transfer = std::make_shared<Transfer>(nofstates);
+	       if (!transfer->precompute(t, node,
+		     link.label_text, link.label_index)) {
+		  complete = false;
+	       }
+	    }
+	    transfers[index].push_back(transfer);
+	 }
+      }
+   }
+   void apply(std::size_t index, std::size_t link_index,
+	 const StateSet& in, StateSet& out) {
+      const DataflowGraph::Link& link = graph.links[index][link_index];
+      transfers[index][link_index]->apply(t, graph.nodes[index],
+	 link.label_text, link.label_index, in, out);
+   }
+   const DataflowGraph& graph;
+   InstanceThread t; // used for the evaluation of conditions
+   /* if complete, no conditions are left to be evaluated
+      and the transfer functions may be used concurrently */
+   bool complete;
+   std::vector<std::vector<TransferPtr>> transfers;
+};
+
+/*
+   instance of a path-independent state machine that starts at the
+   given position with the initial state; local instances do not
+   mark their starting node as visited, just like regular instances
+*/
+struct DataflowInstance {
+   DataflowInstance(InstanceThread&& t, TransferTable& table,
+	    std::size_t start, bool marked) :
+	 t(std::move(t)), table(&table), start(start), marked(marked) {
+   }
+   InstanceThread t;
+   TransferTable* table;
+   std::size_t start; // position
+   bool marked;
+   std::map<std::size_t, StateSet> reached; // by position
+   std::exception_ptr error;
+};
+
+static void solve(DataflowInstance& instance) {
+   TransferTable& table = *instance.table;
+   std::size_t nofstates = instance.t.smi->sm->get_nofstates();
+   // worklist of positions in reverse postorder
+   std::set<std::size_t> worklist;
+   auto propagate = [&](std::size_t index, const StateSet& in) {
+      const auto& links = table.graph.links[index];
+      for (std::size_t link_index = 0; link_index < links.size();
+	    ++link_index) {
+	 StateSet out(nofstates);
+	 table.apply(index, link_index, in, out);
+	 if (out.none()) continue;
+	 std::size_t successor = links[link_index].successor;
+	 auto it = instance.reached.find(successor);
+	 if (it == instance.reached.end()) {
+	    instance.reached.insert(std::make_pair(successor, out));
+	 } else if (!out.is_subset_of(it->second)) {
+	    it->second |= out;
+	 } else {
+	    continue;
+	 }
+	 worklist.insert(successor);
+      }
+   };
+   StateSet initial(nofstates); initial.set(0);
+   if (instance.marked) {
+      instance.reached.insert(std::make_pair(instance.start, initial));
+      worklist.insert(instance.start);
+   } else {
+      propagate(instance.start, initial);
+   }
+   while (worklist.size() > 0) {
+      std::size_t index = *worklist.begin();
+      worklist.erase(worklist.begin());
+      propagate(index, instance.reached[index]);
+   }
+}
+
+/*
+   the fixpoints of instances whose transfer functions are complete,
+   i.e. usually all of them, are computed by a pool of worker threads,
+   all others sequentially
+*/
+static void solve_all(std::vector<DataflowInstance>& instances,
+      unsigned int threads) {
+   std::vector<DataflowInstance*> tasks;
+   for (auto& instance: instances) {
+      if (threads > 1 && instance.table->complete) {
+	 tasks.push_back(&instance);
+      } else {
+	 solve(instance);
+      }
+   }
+   std::atomic<std::size_t> next_task(0);
+   auto worker = [&]() {
+      for (;;) {
+	 std::size_t index = next_task++;
+	 if (index >= tasks.size()) break;
+	 try {
+	    solve(*tasks[index]);
+	 } catch (...) {
+	    tasks[index]->error = std::current_exception();
+	 }
+      }
+   };
+   if (threads > tasks.size()) {
+      threads = tasks.size();
+   }
+   std::vector<std::thread> workers;
+   for (unsigned int i = 1; i < threads; ++i) {
+      workers.emplace_back(worker);
+   }
+   worker();
+   for (auto& t: workers) {
+      t.join();
+   }
+   for (auto& task: tasks) {
+      if (task->error) {
+	 std::rethrow_exception(task->error);
+      }
+   }
+}
+
+/* execute blocks and close handlers for all reached states */
+static void report(ExecutionContext& ec, DataflowInstance& instance) {
+   InstanceThread& t = instance.t;
+   StateMachinePtr sm = t.smi->sm;
+   const DataflowGraph& graph = instance.table->graph;
+   auto report_state = [&](std::size_t index, std::size_t state) {
+      FlowGraphNodePtr node = graph.nodes[index];
+      if (graph.links[index].size() == 0) {
+	 // exit node
+	 t.state = state;
+	 execute_rules(ec, t, "", 0, node, 0);
+	 sm->run_close_handlers(t.state,
+	    std::make_shared<Bindings>(t.bindings));
+	 return;
+      }
+      for (auto& link: graph.links[index]) {
+	 if (!reports(sm, node, link.label_index, state)) continue;
+	 t.state = state;
+	 execute_rules(ec, t, link.label_text, link.label_index, node,
+	    graph.nodes[link.successor]->get_id());
+      }
+   };
+   bool start_pending = !instance.marked;
+   for (auto& entry: instance.reached) {
+      if (start_pending && entry.first >= instance.start) {
+	 report_state(instance.start, 0); start_pending = false;
+      }
+      const StateSet& states = entry.second;
+      for (std::size_t state = states.find_first(); state < states.size();
+	    state = states.find_next(state)) {
+	 report_state(entry.first, state);
+      }
+   }
+   if (start_pending) {
+      report_state(instance.start, 0);
+   }
+}
+
 StateMachinePtr create_dummy_sm(unsigned int id, BindingsPtr bindings) {
    StateMachinePtr dummy = std::make_shared<StateMachine>(bindings,
       "$dummy", id);
@@ -480,78 +1004,195 @@ StateMachinePtr create_dummy_sm(unsigned int id, BindingsPtr bindings) {
    return dummy;
 }
 
+/*
+   path-independent state machines are run as dataflow problems
+   unless their conditions select attributes that may be updated
+   by the blocks of any state machine, including their own
+*/
+static bool attributes_updated(const StateMachineTable& smtab) {
+   for (StateMachineTable::Iterator it = smtab.get_global_begin();
+	 it != smtab.get_global_end(); ++it) {
+      if ((*it)->may_update_attributes()) return true;
+   }
+   for (StateMachineTable::Iterator it = smtab.get_local_begin();
+	 it != smtab.get_local_end(); ++it) {
+      if ((*it)->may_update_attributes()) return true;
+   }
+   return false;
+}
+
+static bool runs_as_dataflow_problem(StateMachinePtr sm,
+      bool attributes_may_be_updated) {
+   return sm->is_path_independent() &&
+      (!attributes_may_be_updated || !sm->conditions_select_attributes());
+}
+
 void execute_state_machines(const Rules& rules, BindingsPtr bindings) {
-   Thread thread; thread.node = get_root(bindings);
-   if (!thread.node) return; // no starting point
+   execute_state_machines(rules, bindings, SMExecutionParameters());
+}
+
+void execute_state_machines(const Rules& rules, BindingsPtr bindings,
+      const SMExecutionParameters& parameters) {
+   unsigned int threads = parameters.threads;
+   if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+   }
+   FlowGraphNodePtr root = get_root(bindings);
+   if (!root) return; // no starting point
    const StateMachineTable& smtab = rules.get_sm_table(bindings);
-   ExecutionContext ec;
-   ec.bindings = bindings; ec.nof_sms = smtab.nof_state_machines() + 1;
-   // create instances of global state machines
+   ExecutionContext ec(nof_node_ids(bindings),
+      smtab.nof_state_machines() + 1);
+   ec.bindings = bindings;
+   // run path-independent state machines as dataflow problems
+   std::vector<StateMachinePtr> path_dependent;
+   std::vector<StateMachinePtr> local_path_dependent;
+   std::vector<StateMachinePtr> local_path_independent;
+   std::map<StateMachinePtr, std::unique_ptr<TransferTable>> tables;
+   std::unique_ptr<DataflowGraph> graph;
+   std::vector<DataflowInstance> dataflow_instances;
+   auto get_table = [&](StateMachinePtr sm) -> TransferTable& {
+      if (!graph) {
+	 graph = std::make_unique<DataflowGraph>(root);
+      }
+      std::unique_ptr<TransferTable>& table = tables[sm];
+      if (!table) table = std::make_unique<TransferTable>(sm, *graph);
+      return *table;
+   };
+   bool updates = attributes_updated(smtab);
    for (StateMachineTable::Iterator it = smtab.get_global_begin();
 	 it != smtab.get_global_end(); ++it) {
-      InstanceThread ithread = create_instance(ec, *it, thread.node);
-      thread.instances.push_back(ithread);
+      StateMachinePtr sm = *it;
+      if (runs_as_dataflow_problem(sm, updates)) {
+	 TransferTable& table = get_table(sm);
+	 dataflow_instances.push_back(DataflowInstance(
+	    create_instance(ec, sm, root), table, 0, true));
+      } else {
+	 path_dependent.push_back(sm);
+      }
+   }
+   for (StateMachineTable::Iterator it = smtab.get_local_begin();
+	 it != smtab.get_local_end(); ++it) {
+      if (runs_as_dataflow_problem(*it, updates)) {
+	 local_path_independent.push_back(*it);
+      } else {
+	 local_path_dependent.push_back(*it);
+      }
+   }
+   if (local_path_independent.size() > 0) {
+      // local instances are created at all reachable nodes
+      if (!graph) {
+	 graph = std::make_unique<DataflowGraph>(root);
+      }
+      InstanceThreads created;
+      for (std::size_t index = 0; index < graph->nodes.size(); ++index) {
+	 FlowGraphNodePtr node = graph->nodes[index];
+	 for (auto& sm: local_path_independent) {
+	    if (!ec.creatable(node->get_id(), sm->get_id())) continue;
+	    check_creation(ec, sm, node, created);
+	    if (created.size() == 0) continue;
+	    dataflow_instances.push_back(DataflowInstance(
+	       std::move(created.back()), get_table(sm), index, false));
+	    created.clear();
+	 }
+      }
+   }
+   solve_all(dataflow_instances, threads);
+   for (auto& instance: dataflow_instances) {
+      report(ec, instance);
+   }
+   if (path_dependent.size() == 0 && local_path_dependent.size() == 0) {
+      return;
+   }
+   Thread thread(root, InstanceThreads());
+   // create instances of the other global state machines
+   for (auto& sm: path_dependent) {
+      thread.instances.push_back(create_instance(ec, sm, thread.node));
    }
    // create dummy state machine
    // (we need this to ensure that all reachable cfg nodes get
    // visited such that creation rules of local state machines can fire)
-   InstanceThread dummy = create_instance(ec,
-      create_dummy_sm(smtab.nof_state_machines(), bindings), thread.node);
-   thread.instances.push_back(dummy);
+   thread.instances.push_back(create_instance(ec,
+      create_dummy_sm(smtab.nof_state_machines(), bindings), thread.node));
+   if (parameters.prioritized) {
+      if (graph) {
+	 ec.prioritize(graph->nodes);
+      } else {
+	 std::vector<FlowGraphNodePtr> order;
+	 reverse_postorder(root, order);
+	 ec.prioritize(order);
+      }
+   }
    // start execution with initial thread
-   ec.threads.push_back(thread);
-   while (ec.threads.size() > 0) {
-      Thread thread = ec.threads.front(); ec.threads.pop_front();
+   ec.schedule(std::move(thread), false);
+   while (!ec.idle()) {
+      Thread thread(ec.next());
+      if (parameters.statistics) ec.count_visit(thread);
       FlowGraphNodePtr node = thread.node;
       unsigned int node_id = node->get_id();
-      std::list<InstanceThread> instances;
-      for (Thread::Iterator iit = thread.instances.begin();
-	    iit != thread.instances.end(); ++iit) {
-	 if (!iit->visit(node_id)) continue;
-	 instances.push_back(*iit);
+      InstanceThreads instances = ec.acquire();
+      for (auto& ithread: thread.instances) {
+	 if (!ithread.visit(node_id)) {
+	    ++ec.dropped; continue;
+	 }
+	 instances.push_back(std::move(ithread));
       }
+      ec.release(std::move(thread.instances));
       // check for new sm instances
-      for (StateMachineTable::Iterator it = smtab.get_local_begin();
-	    it != smtab.get_local_end(); ++it) {
-	 StateMachinePtr sm = *it;
+      for (auto& sm: local_path_dependent) {
 	 if (ec.creatable(node->get_id(), sm->get_id())) {
 	    check_creation(ec, sm, node, instances);
 	 }
       }
-      if (node->get_number_of_outgoing_links() == 0) {
+      std::size_t nof_links = node->get_number_of_outgoing_links();
+      if (nof_links == 0) {
 	 // exit node
-	 for (Thread::Iterator iit = instances.begin();
-	       iit != instances.end(); ++iit) {
-	    execute_rules(ec, *iit, "", 0, node, 0);
-	    iit->smi->sm->run_close_handlers(iit->state, iit->bindings);
+	 for (auto& ithread: instances) {
+	    execute_rules(ec, ithread, "", 0, node, 0);
+	    if (ithread.smi->sm->close_handlers_modify_private_bindings()) {
+	       ithread.unshare_bindings();
+	    }
+	    ithread.smi->sm->run_close_handlers(ithread.state,
+	       std::make_shared<Bindings>(ithread.bindings));
 	 }
       } else {
-	 for (FlowGraphNode::Iterator it = node->begin_links();
-	       it != node->end_links(); ++it) {
-	    std::string label_text = it->first;
-	    unsigned int label_index = label_by_name(bindings, label_text);
-	    FlowGraphNodePtr successor = it->second;
-	    Thread nthread; nthread.node = successor;
+	 for (std::size_t link_index = 0; link_index < nof_links;
+	       ++link_index) {
+	    // instance threads are copied for all but the last link
+	    // where they are moved instead; copies share their
+	    // private bindings until they are modified
+	    bool last_link = link_index + 1 == nof_links;
+	    // link must not be accessed once rules have been
+	    // executed as they may add further links to this node
+	    const FlowGraphNode::Link& link = node->get_link(link_index);
+	    const std::string& label_text = ec.get_label(link);
+	    unsigned int label_index = link.label_index;
+	    FlowGraphNodePtr successor = link.node;
+	    Thread nthread(successor, ec.acquire());
 	    unsigned int id = successor->get_id();
-	    for (Thread::Iterator iit = instances.begin();
-		  iit != instances.end(); ++iit) {
-	       InstanceThread t = *iit;
-	       t.fork_bindings();
+	    for (auto& ithread: instances) {
+	       InstanceThread t(last_link? std::move(ithread): ithread);
 	       if (execute_rules(ec, t, label_text, label_index, node, id)) {
 		  check_cache(ec, t, id);
-		  nthread.instances.push_back(t);
+		  nthread.instances.push_back(std::move(t));
 	       }
 	    }
 	    if (nthread.instances.size() > 0) {
 	       // note that we continue the actual thread as far
 	       // as possible to avoid races in case of caching
 	       // when two different threads hit the same function
-	       ec.threads.push_front(nthread);
+	       // unless the threads are prioritized
+	       ec.schedule(std::move(nthread), true);
+	    } else {
+	       ec.release(std::move(nthread.instances));
 	    }
 	 }
       }
+      ec.release(std::move(instances));
    }
    ec.run_close_handlers();
+   if (parameters.statistics) {
+      ec.print_statistics(*parameters.statistics);
+   }
 }
 
 } // namespace Astl
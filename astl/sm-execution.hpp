@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,6 +19,7 @@
 #ifndef ASTL_SM_EXECUTION_H
 #define ASTL_SM_EXECUTION_H
 
+#include <ostream>
 #include <astl/bindings.hpp>
 #include <astl/exception.hpp>
 #include <astl/rules.hpp>
@@ -26,7 +27,23 @@
 
 namespace Astl {
 
+   struct SMExecutionParameters {
+      SMExecutionParameters() :
+	    threads(1), prioritized(false), statistics(nullptr) {
+      }
+      /* number of threads for instances of path-independent
+	 state machines (0 for the number of cores) */
+      unsigned int threads;
+      /* process pending threads in reverse postorder of their nodes
+	 and coalesce pending threads for the same node */
+      bool prioritized;
+      /* if non-null, visit statistics are printed to it */
+      std::ostream* statistics;
+   };
+
    void execute_state_machines(const Rules& rules, BindingsPtr bindings);
+   void execute_state_machines(const Rules& rules, BindingsPtr bindings,
+      const SMExecutionParameters& parameters);
 
 } // namespace Astl
 
@@ -0,0 +1,513 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <astl/attribute.hpp>
+#include <astl/binary-coding.hpp>
+#include <astl/bindings.hpp>
+#include <astl/exception.hpp>
+#include <astl/flow-graph.hpp>
+#include <astl/integer.hpp>
+#include <astl/snapshot.hpp>
+#include <astl/syntax-tree-file.hpp>
+
+namespace Astl {
+
+static const char magic[] = "ASTLSNP1";
+static constexpr std::size_t magic_len = 8;
+
+/* entries of flow graph node dictionaries which are derived */
+static bool derived_fgnode_entry(const std::string& key) {
+   return key == "astnode" || key == "branch";
+}
+
+static bool serializable(const AttributePtr& at) {
+   switch (at->get_type()) {
+      case Attribute::function:
+      case Attribute::istream:
+      case Attribute::ostream:
+	 return false;
+      default:
+	 return true;
+   }
+}
+
+namespace {
+
+   /* collects everything that is reachable from the tree to be saved */
+   class SnapshotEncoder {
+      public:
+	 SnapshotEncoder(NodePtr root);
+	 void write(std::ostream& out) const;
+
+      private:
+	 std::vector<NodePtr> roots;
+	 std::unordered_set<const Node*> nodes_seen;
+	 std::vector<AttributePtr> attributes;
+	 std::unordered_map<const Attribute*, std::size_t> attribute_ids;
+	 std::vector<FlowGraphNodePtr> fgnodes;
+	 std::unordered_map<const FlowGraphNode*, std::size_t> fgnode_ids;
+
+	 void add_tree(const NodePtr& root);
+	 void add_attribute(const AttributePtr& at);
+	 void add_fgnode(const FlowGraphNodePtr& fgnode);
+	 void scan_attribute(const AttributePtr& at);
+	 void scan_fgnode(const FlowGraphNodePtr& fgnode);
+	 std::size_t ref(const AttributePtr& at) const;
+   };
+
+} // anonymous namespace
+
+SnapshotEncoder::SnapshotEncoder(NodePtr root) {
+   add_tree(root);
+   std::size_t scanned_attributes = 0;
+   std::size_t scanned_fgnodes = 0;
+   while (scanned_attributes < attributes.size() ||
+	 scanned_fgnodes < fgnodes.size()) {
+      /* copies as scanning may reallocate the worklists */
+      if (scanned_attributes < attributes.size()) {
+	 AttributePtr at = attributes[scanned_attributes++];
+	 scan_attribute(at);
+      } else {
+	 FlowGraphNodePtr fgnode = fgnodes[scanned_fgnodes++];
+	 scan_fgnode(fgnode);
+      }
+   }
+}
+
+void SnapshotEncoder::add_tree(const NodePtr& root) {
+   if (!root || nodes_seen.find(root.get()) != nodes_seen.end()) return;
+   roots.push_back(root);
+   std::vector<const Node*> stack;
+   stack.push_back(root.get());
+   while (stack.size() > 0) {
+      const Node* node = stack.back(); stack.pop_back();
+      if (!nodes_seen.insert(node).second) continue;
+      if (node->has_attributes()) add_attribute(node->get_attribute());
+      if (!node->is_leaf()) {
+	 for (std::size_t i = node->size(); i > 0; --i) {
+	    const NodePtr& subnode = node->get_operand(i - 1);
+	    if (subnode) stack.push_back(subnode.get());
+	 }
+      }
+   }
+}
+
+void SnapshotEncoder::add_attribute(const AttributePtr& at) {
+   if (!at || !serializable(at)) return;
+   if (attribute_ids.find(at.get()) != attribute_ids.end()) return;
+   attribute_ids[at.get()] = attributes.size();
+   attributes.push_back(at);
+}
+
+void SnapshotEncoder::add_fgnode(const FlowGraphNodePtr& fgnode) {
+   if (fgnode_ids.find(fgnode.get()) != fgnode_ids.end()) return;
+   fgnode_ids[fgnode.get()] = fgnodes.size();
+   fgnodes.push_back(fgnode);
+}
+
+void SnapshotEncoder::scan_attribute(const AttributePtr& at) {
+   switch (at->get_type()) {
+      case Attribute::dictionary:
+	 for (auto it = at->get_pairs_begin(); it != at->get_pairs_end();
+	       ++it) {
+	    add_attribute(it->second);
+	 }
+	 break;
+      case Attribute::list:
+	 for (std::size_t i = 0; i < at->size(); ++i) {
+	    add_attribute(at->get_value(i));
+	 }
+	 break;
+      case Attribute::tree:
+	 add_tree(at->get_node());
+	 break;
+      case Attribute::flow_graph_node:
+	 add_fgnode(at->get_fgnode());
+	 break;
+      default:
+	 break;
+   }
+}
+
+void SnapshotEncoder::scan_fgnode(const FlowGraphNodePtr& fgnode) {
+   add_tree(fgnode->get_node());
+   for (auto it = fgnode->begin_links(); it != fgnode->end_links(); ++it) {
+      add_fgnode(it->node);
+   }
+   AttributePtr at = fgnode->get_attribute();
+   for (auto it = at->get_pairs_begin(); it != at->get_pairs_end(); ++it) {
+      if (!derived_fgnode_entry(it->first)) add_attribute(it->second);
+   }
+}
+
+std::size_t SnapshotEncoder::ref(const AttributePtr& at) const {
+   if (!at) return 0;
+   auto it = attribute_ids.find(at.get());
+   if (it == attribute_ids.end()) return 0; // not serializable
+   return it->second + 1;
+}
+
+void SnapshotEncoder::write(std::ostream& out) const {
+   /* all trees are saved as subtrees of one tree */
+   NodePtr trees = std::make_shared<Node>(Location(), Operator("snapshot"));
+   for (auto& root: roots) {
+      *trees += root;
+   }
+   std::ostringstream tree_section;
+   std::vector<const Node*> nodes;
+   write_syntax_tree(tree_section, trees, nodes);
+   std::unordered_map<const Node*, std::size_t> node_ids;
+   for (std::size_t i = 0; i < nodes.size(); ++i) {
+      node_ids[nodes[i]] = i;
+   }
+   auto node_ref = [&](const NodePtr& node) -> std::size_t {
+      if (!node) return 0;
+      return node_ids.at(node.get()) + 1;
+   };
+
+   BinaryStringTable strings;
+   BinaryEncoder enc;
+   enc.put(fgnodes.size());
+   for (auto& fgnode: fgnodes) {
+      enc.put(fgnode->get_id());
+      enc.put(strings.add(fgnode->get_type()));
+      enc.put(fgnode->get_type_number());
+      enc.put(node_ref(fgnode->get_node()));
+   }
+   enc.put(attributes.size());
+   for (auto& at: attributes) {
+      enc.put(at->get_type());
+      switch (at->get_type()) {
+	 case Attribute::dictionary:
+	    enc.put(at->size());
+	    for (auto it = at->get_pairs_begin(); it != at->get_pairs_end();
+		  ++it) {
+	       enc.put(strings.add(it->first));
+	       enc.put(ref(it->second));
+	    }
+	    break;
+	 case Attribute::list:
+	    enc.put(at->size());
+	    for (std::size_t i = 0; i < at->size(); ++i) {
+	       enc.put(ref(at->get_value(i)));
+	    }
+	    break;
+	 case Attribute::match_result:
+	    enc.put(at->size() + 1);
+	    enc.put(strings.add(at->get_string()));
+	    for (std::size_t i = 0; i < at->size(); ++i) {
+	       enc.put(strings.add(at->get_value(i)->get_string()));
+	    }
+	    break;
+	 case Attribute::tree:
+	    enc.put(node_ref(at->get_node()));
+	    break;
+	 case Attribute::flow_graph_node:
+	    enc.put(fgnode_ids.at(at->get_fgnode().get()));
+	    break;
+	 case Attribute::string:
+	    enc.put(strings.add(at->get_string()));
+	    break;
+	 case Attribute::integer:
+	    enc.put(strings.add(at->get_integer()->to_string()));
+	    break;
+	 case Attribute::boolean:
+	    enc.put(at->convert_to_bool());
+	    break;
+	 default:
+	    break;
+      }
+   }
+   for (auto& fgnode: fgnodes) {
+      enc.put(fgnode->get_number_of_outgoing_links());
+      for (auto it = fgnode->begin_links(); it != fgnode->end_links(); ++it) {
+	 enc.put(fgnode_ids.at(it->node.get()));
+	 enc.put(strings.add(it->label));
+	 enc.put(it->label_index);
+	 enc.put(it->labeled);
+      }
+      AttributePtr at = fgnode->get_attribute();
+      std::size_t count = 0;
+      for (auto it = at->get_pairs_begin(); it != at->get_pairs_end(); ++it) {
+	 if (!derived_fgnode_entry(it->first)) ++count;
+      }
+      enc.put(count);
+      for (auto it = at->get_pairs_begin(); it != at->get_pairs_end(); ++it) {
+	 if (!derived_fgnode_entry(it->first)) {
+	    enc.put(strings.add(it->first));
+	    enc.put(ref(it->second));
+	 }
+      }
+   }
+   /* dictionaries of nodes are saved if they are not empty
+      or if they are referred to by other attributes */
+   std::vector<std::pair<std::size_t, std::size_t>> node_attributes;
+   for (std::size_t i = 0; i < nodes.size(); ++i) {
+      auto it = attribute_ids.find(nodes[i]->get_attribute().get());
+      if (it != attribute_ids.end()) {
+	 node_attributes.push_back(std::make_pair(i, it->second));
+      }
+   }
+   enc.put(node_attributes.size());
+   for (auto& entry: node_attributes) {
+      enc.put(entry.first); enc.put(entry.second);
+   }
+
+   BinaryEncoder header;
+   header.put_raw(magic, magic_len);
+   header.put(tree_section.str());
+   strings.encode(header);
+   const std::string& hbuf = header.get_buffer();
+   out.write(hbuf.data(), hbuf.size());
+   const std::string& buf = enc.get_buffer();
+   out.write(buf.data(), buf.size());
+}
+
+void write_snapshot(std::ostream& out, NodePtr root) {
+   if (!root) {
+      throw Exception("no syntax tree to be saved");
+   }
+   SnapshotEncoder encoder(root);
+   encoder.write(out);
+}
+
+void write_snapshot(const std::string& path, NodePtr root) {
+   std::ofstream out(path, std::ios::binary);
+   if (out) {
+      write_snapshot(out, root);
+      out.close();
+   }
+   if (!out) {
+      std::ostringstream os;
+      os << "unable to write snapshot to " << path;
+      throw Exception(os.str());
+   }
+}
+
+// reader ===================================================================
+
+namespace {
+
+   class SnapshotDecoder {
+      public:
+	 SnapshotDecoder(BinaryDecoder& dec);
+	 NodePtr get_root() const {
+	    return root;
+	 }
+
+      private:
+	 NodePtr root;
+	 std::vector<NodePtr> nodes;
+	 std::vector<std::string> strings;
+	 std::vector<FlowGraphNodePtr> fgnodes;
+	 std::vector<AttributePtr> attributes;
+
+	 const std::string& get_string(BinaryDecoder& d) {
+	    return strings[d.get_index(strings.size())];
+	 }
+	 NodePtr get_node(BinaryDecoder& d) {
+	    std::size_t index = d.get_index(nodes.size() + 1);
+	    return index? nodes[index - 1]: nullptr;
+	 }
+	 AttributePtr get_ref(BinaryDecoder& d) {
+	    std::size_t index = d.get_index(attributes.size() + 1);
+	    return index? attributes[index - 1]: nullptr;
+	 }
+	 void decode_attributes(BinaryDecoder& d, bool fill);
+   };
+
+} // anonymous namespace
+
+/* the attributes are decoded twice: first to create them,
+   and then to fill the containers as they may refer to
+   attributes which follow them */
+void SnapshotDecoder::decode_attributes(BinaryDecoder& d, bool fill) {
+   for (auto& at: attributes) {
+      unsigned int type = d.get();
+      switch (type) {
+	 case Attribute::dictionary: {
+	    if (!fill) at = std::make_shared<Attribute>(Attribute::dictionary);
+	    std::size_t count = d.get();
+	    for (std::size_t i = 0; i < count; ++i) {
+	       const std::string& key = get_string(d);
+	       AttributePtr value = get_ref(d);
+	       if (fill) at->update(key, value);
+	    }
+	    break;
+	 }
+	 case Attribute::list: {
+	    if (!fill) at = std::make_shared<Attribute>(Attribute::list);
+	    std::size_t count = d.get();
+	    for (std::size_t i = 0; i < count; ++i) {
+	       AttributePtr value = get_ref(d);
+	       if (fill) at->push_back(value);
+	    }
+	    break;
+	 }
+	 case Attribute::match_result: {
+	    Attribute::SubtokenVector subtokens(d.get_count(1));
+	    if (subtokens.size() == 0) throw MalformedBinaryData();
+	    for (auto& subtoken: subtokens) {
+	       subtoken = get_string(d);
+	    }
+	    if (!fill) at = std::make_shared<Attribute>(subtokens);
+	    break;
+	 }
+	 case Attribute::tree: {
+	    NodePtr node = get_node(d);
+	    if (!fill) at = std::make_shared<Attribute>(node);
+	    break;
+	 }
+	 case Attribute::flow_graph_node: {
+	    std::size_t index = d.get_index(fgnodes.size());
+	    if (!fill) at = std::make_shared<Attribute>(fgnodes[index]);
+	    break;
+	 }
+	 case Attribute::string: {
+	    const std::string& s = get_string(d);
+	    if (!fill) at = std::make_shared<Attribute>(s);
+	    break;
+	 }
+	 case Attribute::integer: {
+	    const std::string& s = get_string(d);
+	    if (!fill) {
+	       try {
+		  at = std::make_shared<Attribute>(
+		     std::make_shared<Integer>(s.c_str(), Location()));
+	       } catch (Exception&) {
+		  throw MalformedBinaryData();
+	       }
+	    }
+	    break;
+	 }
+	 case Attribute::boolean: {
+	    bool value = d.get();
+	    if (!fill) at = std::make_shared<Attribute>(value);
+	    break;
+	 }
+	 default:
+	    throw MalformedBinaryData();
+      }
+   }
+}
+
+SnapshotDecoder::SnapshotDecoder(BinaryDecoder& dec) {
+   if (std::memcmp(dec.get_raw(magic_len), magic, magic_len) != 0) {
+      throw MalformedBinaryData();
+   }
+   std::size_t len = dec.get();
+   const char* tree_section = dec.get_raw(len);
+   NodePtr trees;
+   try {
+      trees = read_syntax_tree(tree_section, len, nodes);
+   } catch (Exception&) {
+      throw MalformedBinaryData();
+   }
+   const Node& roots = *trees;
+   if (roots.is_leaf() || roots.size() == 0) throw MalformedBinaryData();
+   root = roots.get_operand(0);
+
+   strings.resize(dec.get_count(1));
+   for (auto& s: strings) {
+      s = dec.get_string();
+   }
+
+   /* the flow graph nodes refer to the restored graph dictionary
+      through their bindings which is defined at the end */
+   BindingsPtr bindings = std::make_shared<Bindings>();
+   fgnodes.resize(dec.get_count(4));
+   for (auto& fgnode: fgnodes) {
+      std::size_t id = dec.get();
+      const std::string& type = get_string(dec);
+      std::size_t type_number = dec.get();
+      NodePtr node = get_node(dec);
+      fgnode = std::make_shared<FlowGraphNode>(bindings,
+	 id, type, type_number, node);
+   }
+
+   attributes.resize(dec.get_count(1));
+   BinaryDecoder contents = dec;
+   decode_attributes(dec, false);
+   decode_attributes(contents, true);
+
+   for (auto& fgnode: fgnodes) {
+      std::size_t count = dec.get();
+      for (std::size_t i = 0; i < count; ++i) {
+	 FlowGraphNodePtr target = fgnodes[dec.get_index(fgnodes.size())];
+	 const std::string& label = get_string(dec);
+	 std::size_t label_index = dec.get();
+	 bool labeled = dec.get();
+	 fgnode->restore_link(FlowGraphNode::Link{label, label_index,
+	    labeled, target});
+      }
+      AttributePtr at = fgnode->get_attribute();
+      count = dec.get();
+      for (std::size_t i = 0; i < count; ++i) {
+	 const std::string& key = get_string(dec);
+	 at->update(key, get_ref(dec));
+      }
+   }
+
+   std::size_t count = dec.get();
+   for (std::size_t i = 0; i < count; ++i) {
+      NodePtr node = nodes[dec.get_index(nodes.size())];
+      AttributePtr at = attributes[dec.get_index(attributes.size())];
+      if (at->get_type() != Attribute::dictionary) {
+	 throw MalformedBinaryData();
+      }
+      node->set_attribute(at);
+   }
+   if (!dec.at_end()) throw MalformedBinaryData();
+
+   AttributePtr rootat = root->get_attribute();
+   if (rootat->is_defined("graph")) {
+      bindings->define("graph", rootat->get_value("graph"));
+   }
+}
+
+NodePtr read_snapshot(const std::string& path) {
+   MappedFile file(path);
+   try {
+      BinaryDecoder dec(file.begin(), file.begin() + file.size());
+      SnapshotDecoder decoder(dec);
+      return decoder.get_root();
+   } catch (MalformedBinaryData&) {
+      std::ostringstream os;
+      os << path << " is not a valid snapshot";
+      throw Exception(os.str());
+   }
+}
+
+// generator ================================================================
+
+NodePtr SnapshotReader::gen(int& argc, char**& argv) {
+   if (argc == 0) {
+      throw Exception("no snapshot given");
+   }
+   char* path = *argv++; --argc;
+   return read_snapshot(path);
+}
+
+} // namespace Astl
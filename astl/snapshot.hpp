@@ -0,0 +1,91 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_SNAPSHOT_H
+#define ASTL_SNAPSHOT_H
+
+#include <iostream>
+#include <string>
+#include <astl/generator.hpp>
+#include <astl/syntax-tree.hpp>
+
+namespace Astl {
+
+   /*
+      A snapshot preserves an attributed syntax tree such that
+      later runs can continue with the results of an expensive
+      attribution instead of repeating it. It includes
+
+	 - the syntax tree in the binary interchange format
+	   (see syntax-tree-file.hpp),
+	 - the attribute dictionaries of all nodes and all attributes
+	   reachable from them, including the flow graph reachable
+	   from root.graph, and
+	 - all further trees and subtrees referred to by attributes.
+
+      The layout, all integers encoded as varints:
+
+	 magic ("ASTLSNP1", 8 bytes)
+	 length of the tree section, tree section
+	 string table: number of strings, strings
+	 number of flow graph nodes,
+	    for each of them its id, type (string index),
+	    type number, and syntax tree node (preorder number + 1,
+	    0 if none)
+	 number of attributes,
+	    for each of them its type and contents (see below)
+	 for each flow graph node its links (number of links,
+	    for each link its target, label (string index),
+	    label index, and whether it is labeled) and the entries
+	    of its dictionary besides astnode and branch
+	 number of nodes with attributes,
+	    for each of them its preorder number and its
+	    attribute dictionary
+
+      The tree section holds a tree whose root has the saved tree
+      as its first subnode, followed by all other trees referred
+      to by attributes. References to attributes are encoded as
+      0 for null values and as attribute index + 1 otherwise.
+      Dictionary entries consist of a key (string index) and
+      a value. Functions and streams cannot be saved; they are
+      treated as non-serializable and restored as null values.
+      Attribute identities are preserved, i.e. attributes which
+      are shared remain shared when restored.
+
+      As the flow graph nodes of a restored tree keep their ids
+      and refer to the restored root.graph, new flow graph nodes
+      can be added to it by later runs.
+   */
+
+   void write_snapshot(std::ostream& out, NodePtr root);
+   void write_snapshot(const std::string& path, NodePtr root);
+   NodePtr read_snapshot(const std::string& path);
+
+   /**
+    * Syntax tree generator which takes the next argument as
+    * the name of a snapshot whose attributed tree is then
+    * processed by run().
+    */
+   class SnapshotReader: public SyntaxTreeGenerator {
+      public:
+	 virtual NodePtr gen(int& argc, char**& argv);
+   };
+
+} // namespace Astl
+
+#endif
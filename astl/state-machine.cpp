@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -23,6 +23,7 @@
 #include <astl/exception.hpp>
 #include <astl/execution.hpp>
 #include <astl/expression.hpp>
+#include <astl/function.hpp>
 #include <astl/operators.hpp>
 #include <astl/rules.hpp>
 #include <astl/state-machine.hpp>
@@ -34,13 +35,13 @@ namespace Astl {
 StateMachine::StateMachine(BindingsPtr bindings,
       const std::string& name, std::size_t id) :
    abstract(false), global(true),
-   name(name), bindings(bindings), id(id) {
+   name(name), bindings(bindings), modifying_close_handlers(false), id(id) {
 }
 
 StateMachine::StateMachine(BindingsPtr bindings,
       const std::string& name) :
    abstract(true), global(true),
-   name(name), bindings(bindings) {
+   name(name), bindings(bindings), modifying_close_handlers(false) {
 }
 
 void StateMachine::import_asm(StateMachinePtr sm) {
@@ -173,6 +174,335 @@ void StateMachine::update_function_bindings(BindingsPtr local_bindings) const {
    }
 }
 
+/*
+   conservative check whether the execution of the given code may
+   modify the private bindings of a state machine instance; this is
+   the case if a private variable is the target of an assignment or
+   a similar operation, if a local function is referenced (as it
+   has access to the private bindings), or if a function is
+   constructed (which could capture the private bindings)
+*/
+/*
+   variable at the root of the designator that is modified
+   by the given operation, if any
+*/
+static NodePtr modified_variable(NodePtr node) {
+   NodePtr target;
+   Operator op = node->get_op();
+   if (op == Op::assignment) {
+      target = node->get_operand(0)->get_operand(0);
+   } else if (op == Op::prefix_increment || op == Op::prefix_decrement ||
+	 op == Op::postfix_increment || op == Op::postfix_decrement ||
+	 op == Op::delete_statement) {
+      target = node->get_operand(0);
+   }
+   while (target && !target->is_leaf() && target->size() > 0) {
+      target = target->get_operand(0);
+   }
+   if (target && target->is_leaf()) return target;
+   return nullptr;
+}
+
+static bool may_modify(NodePtr node,
+      const std::set<std::string>& private_vars,
+      const std::set<std::string>& functions) {
+   if (!node) return false;
+   if (node->is_leaf()) {
+      return functions.find(node->get_token().get_text()) != functions.end();
+   }
+   if (node->get_op() == Op::function_constructor) return true;
+   NodePtr target = modified_variable(node);
+   if (target && private_vars.find(
+	    target->get_token().get_text()) != private_vars.end()) {
+      return true;
+   }
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      if (may_modify(node->get_operand(i), private_vars, functions)) {
+	 return true;
+      }
+   }
+   return false;
+}
+
+void StateMachine::analyze_private_modifications() {
+   std::set<std::string> private_vars;
+   for (auto& var: private_var_list) {
+      private_vars.insert(var.name);
+   }
+   std::set<std::string> functions;
+   for (auto& function: local_functions) {
+      functions.insert(function.first);
+   }
+   modifying_close_handlers = false;
+   for (auto& handler: close_handlers) {
+      if (may_modify(handler.block, private_vars, functions)) {
+	 modifying_close_handlers = true;
+      }
+   }
+   modifying_rules.clear();
+   for (auto& rule: rules) {
+      bool modifies = may_modify(rule->get_tree_expression(),
+	    private_vars, functions) ||
+	 may_modify(rule->get_node_condition(), private_vars, functions);
+      for (auto& alt: rule->alternatives) {
+	 if (may_modify(alt->block, private_vars, functions) ||
+	       may_modify(alt->return_node, private_vars, functions) ||
+	       (alt->get_action() == StateMachineRuleAlternative::close &&
+		  modifying_close_handlers)) {
+	    modifies = true;
+	 }
+      }
+      if (modifies) {
+	 modifying_rules.insert(rule);
+      }
+   }
+}
+
+bool StateMachine::modifies_private_bindings(StateMachineRulePtr rule) const {
+   return modifying_rules.find(rule) != modifying_rules.end();
+}
+
+bool StateMachine::close_handlers_modify_private_bindings() const {
+   return modifying_close_handlers;
+}
+
+/*
+   names that are bound locally when a condition is evaluated, i.e.
+   the variables bound by the tree expression and those bound by
+   the state machine execution; embedded expressions do not bind names
+*/
+static void collect_local_names(NodePtr node, std::set<std::string>& names) {
+   if (!node) return;
+   if (node->is_leaf()) {
+      names.insert(node->get_token().get_text());
+      return;
+   }
+   if (node->get_op() == Op::expression) return;
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      collect_local_names(node->get_operand(i), names);
+   }
+}
+
+/* variable at the root of the given designator, if any */
+static NodePtr root_variable(NodePtr designator) {
+   while (designator && !designator->is_leaf() &&
+	 (designator->get_op() == Op::DOT ||
+	    designator->get_op() == Op::LBRACE ||
+	    designator->get_op() == Op::LBRACKET)) {
+      designator = designator->get_operand(0);
+   }
+   if (designator && designator->is_leaf()) return designator;
+   return nullptr;
+}
+
+static bool is_update(Operator op) {
+   return op == Op::assignment || op == Op::delete_statement ||
+      op == Op::prefix_increment || op == Op::prefix_decrement ||
+      op == Op::postfix_increment || op == Op::postfix_decrement;
+}
+
+/*
+   conservative check whether a condition evaluates to the same
+   value whenever it is evaluated at the same node: it must neither
+   call nor construct functions, must not update anything, and may
+   reference local names only as even constant global variables
+   may refer to mutable containers
+*/
+static bool is_pure_condition(NodePtr node,
+      const std::set<std::string>& locals) {
+   if (!node || node->is_leaf()) return true;
+   Operator op = node->get_op();
+   if (op == Op::function_call || op == Op::function_constructor ||
+	 is_update(op)) {
+      return false;
+   }
+   if (op == Op::designator || op == Op::EXISTS) {
+      NodePtr var = root_variable(node->get_operand(0));
+      if (!var || locals.find(var->get_token().get_text()) == locals.end()) {
+	 return false;
+      }
+   }
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      if (!is_pure_condition(node->get_operand(i), locals)) return false;
+   }
+   return true;
+}
+
+/* does the given condition select attributes or container members? */
+static bool selects_attributes(NodePtr node) {
+   if (!node || node->is_leaf()) return false;
+   Operator op = node->get_op();
+   if (op == Op::DOT || op == Op::LBRACE || op == Op::LBRACKET ||
+	 op == Op::EXISTS) {
+      return true;
+   }
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      if (selects_attributes(node->get_operand(i))) return true;
+   }
+   return false;
+}
+
+/*
+   may the given code update attributes or container members?
+   this includes all function calls as builtin functions like push
+   update containers in place
+*/
+static bool may_update_attributes(NodePtr node) {
+   if (!node || node->is_leaf()) return false;
+   Operator op = node->get_op();
+   if (op == Op::function_call) return true;
+   if (is_update(op)) {
+      NodePtr target = node->get_operand(0);
+      if (op == Op::assignment) target = target->get_operand(0);
+      while (!target->is_leaf() &&
+	    (target->get_op() == Op::expression ||
+	       target->get_op() == Op::primary ||
+	       target->get_op() == Op::designator)) {
+	 target = target->get_operand(0);
+      }
+      if (!target->is_leaf()) return true;
+   }
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      if (may_update_attributes(node->get_operand(i))) return true;
+   }
+   return false;
+}
+
+/* names of the variables declared within the given code */
+static void collect_declared_names(NodePtr node,
+      std::set<std::string>& names) {
+   if (!node || node->is_leaf()) return;
+   Operator op = node->get_op();
+   if (op == Op::var_statement || op == Op::foreach_statement) {
+      for (std::size_t i = 0; i < node->size(); ++i) {
+	 NodePtr operand = node->get_operand(i);
+	 if (operand->is_leaf()) {
+	    names.insert(operand->get_token().get_text());
+	 }
+      }
+   }
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      collect_declared_names(node->get_operand(i), names);
+   }
+}
+
+/*
+   may the given code invoke functions that are not builtin?
+   functions of the state machine, global functions, rule sets,
+   constructed functions, and all functions that are not called
+   directly by the name of a global builtin function are
+   considered to be user functions
+*/
+bool StateMachine::calls_user_functions(NodePtr node,
+      const std::set<std::string>& declared) const {
+   if (!node || node->is_leaf()) return false;
+   Operator op = node->get_op();
+   if (op == Op::function_constructor) return true;
+   if (op == Op::function_call) {
+      NodePtr callee = node->get_operand(0)->get_operand(0);
+      if (callee->is_leaf() || callee->get_op() != Op::designator ||
+	    !callee->get_operand(0)->is_leaf()) {
+	 return true;
+      }
+      std::string fname = callee->get_operand(0)->get_token().get_text();
+      if (declared.find(fname) != declared.end() ||
+	    local_functions.find(fname) != local_functions.end() ||
+	    !bindings->defined(fname) || !bindings->is_const(fname)) {
+	 return true;
+      }
+      AttributePtr at = bindings->get(fname);
+      if (!at || at->get_type() != Attribute::function ||
+	    !std::dynamic_pointer_cast<BuiltinFunction>(at->get_func())) {
+	 return true;
+      }
+   }
+   for (std::size_t i = 0; i < node->size(); ++i) {
+      if (calls_user_functions(node->get_operand(i), declared)) return true;
+   }
+   return false;
+}
+
+bool StateMachine::calls_user_functions(NodePtr node) const {
+   std::set<std::string> declared;
+   collect_declared_names(node, declared);
+   return calls_user_functions(node, declared);
+}
+
+bool StateMachine::is_path_independent() const {
+   /* the values of shared variables depend on the order
+      in which paths are taken */
+   if (abstract ||
+	 private_var_list.size() > 0 || shared_var_list.size() > 0) {
+      return false;
+   }
+   for (auto& rule: rules) {
+      for (auto& alt: rule->alternatives) {
+	 if (alt->action == StateMachineRuleAlternative::cache ||
+	       alt->action == StateMachineRuleAlternative::retract) {
+	    return false;
+	 }
+      }
+   }
+   /* user functions may have arbitrary side effects,
+      including updates of global variables */
+   for (auto& rule: rules) {
+      for (auto& alt: rule->alternatives) {
+	 if (calls_user_functions(alt->block) ||
+	       calls_user_functions(alt->return_node)) {
+	    return false;
+	 }
+      }
+   }
+   for (auto& rule: creating_rules) {
+      if (calls_user_functions(rule->block)) return false;
+   }
+   for (auto& handler: close_handlers) {
+      if (calls_user_functions(handler.block)) return false;
+   }
+   /* conditions must not depend on anything but the node */
+   for (auto* list: {&rules, &creating_rules}) {
+      for (auto& rule: *list) {
+	 std::set<std::string> locals = {"node", "current_state", "label"};
+	 collect_local_names(rule->get_tree_expression(), locals);
+	 if (!is_pure_condition(rule->get_tree_expression(), locals) ||
+	       !is_pure_condition(rule->get_node_condition(), locals)) {
+	    return false;
+	 }
+      }
+   }
+   return true;
+}
+
+bool StateMachine::conditions_select_attributes() const {
+   for (auto* list: {&rules, &creating_rules}) {
+      for (auto& rule: *list) {
+	 if (selects_attributes(rule->get_tree_expression()) ||
+	       selects_attributes(rule->get_node_condition())) {
+	    return true;
+	 }
+      }
+   }
+   return false;
+}
+
+bool StateMachine::may_update_attributes() const {
+   for (auto& rule: rules) {
+      for (auto& alt: rule->alternatives) {
+	 if (Astl::may_update_attributes(alt->block) ||
+	       Astl::may_update_attributes(alt->return_node)) {
+	    return true;
+	 }
+      }
+   }
+   for (auto& rule: creating_rules) {
+      if (Astl::may_update_attributes(rule->block)) return true;
+   }
+   for (auto& handler: close_handlers) {
+      if (Astl::may_update_attributes(handler.block)) return true;
+   }
+   return false;
+}
+
 bool StateMachine::is_abstract() const {
    return abstract;
 }
@@ -233,6 +563,70 @@ StateMachine::Iterator StateMachine::get_creating_rules_end() const {
    return creating_rules.end();
 }
 
+static bool nodetype_matches(StateMachineRulePtr rule,
+      std::size_t node_type) {
+   const NodeTypeSet& ntset = rule->get_nodetypes();
+   return ntset.size() == 0 ||
+      (node_type < ntset.size() && ntset.test(node_type));
+}
+
+const StateMachine::DispatchList& StateMachine::get_dispatch_list(
+      std::size_t node_type, std::size_t label_index, int state) const {
+   assert(!abstract && state >= 0 && state < (int)stateByName.size());
+   if (node_type >= dispatch_table.size()) {
+      dispatch_table.resize(node_type + 1);
+   }
+   std::vector<StateDispatch>& by_label = dispatch_table[node_type];
+   if (label_index >= by_label.size()) {
+      by_label.resize(label_index + 1);
+   }
+   StateDispatch& by_state = by_label[label_index];
+   if (by_state.size() == 0) {
+      by_state.resize(stateByName.size());
+   }
+   std::unique_ptr<DispatchList>& list = by_state[state];
+   if (list) return *list;
+   list = std::make_unique<DispatchList>();
+   for (auto& rule: rules) {
+      if (!nodetype_matches(rule, node_type)) continue;
+      Dispatch dispatch = {rule, {}};
+      for (auto& alt: rule->alternatives) {
+	 const LabelSet& labels = alt->get_labels();
+	 if (labels.size() > 0 &&
+	       (label_index >= labels.size() || !labels.test(label_index))) {
+	    continue;
+	 }
+	 const StateSet& states = alt->get_states();
+	 if (states.size() > 0 &&
+	       (state >= (int)states.size() || !states.test(state))) {
+	    continue;
+	 }
+	 dispatch.alternatives.push_back(alt);
+      }
+      /* rules without applicable alternatives have no effect */
+      if (dispatch.alternatives.size() > 0) {
+	 list->push_back(std::move(dispatch));
+      }
+   }
+   return *list;
+}
+
+const StateMachine::RuleList& StateMachine::get_creating_rules(
+      std::size_t node_type) const {
+   if (node_type >= creating_rules_table.size()) {
+      creating_rules_table.resize(node_type + 1);
+   }
+   std::unique_ptr<RuleList>& list = creating_rules_table[node_type];
+   if (list) return *list;
+   list = std::make_unique<RuleList>();
+   for (auto& rule: creating_rules) {
+      if (nodetype_matches(rule, node_type)) {
+	 list->push_back(rule);
+      }
+   }
+   return *list;
+}
+
 void StateMachine::run_close_handlers(int state,
 	 BindingsPtr local_bindings) const {
    assert(state >= 0);
@@ -701,6 +1095,7 @@ StateMachinePtr construct_sm(BindingsPtr bindings, NodePtr root,
       add_functions(sm, funcs->get_operand(0));
    }
    add_rules(sm, bindings, rules);
+   sm->analyze_private_modifications();
    return sm;
 }
 
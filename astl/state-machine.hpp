@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -22,7 +22,9 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 #include <boost/dynamic_bitset.hpp>
 #include <astl/exception.hpp>
 #include <astl/flow-graph.hpp>
@@ -131,6 +133,8 @@ namespace Astl {
 	    NodePtr init_expr, const Location& loc);
 	 void add_close_handler(const StateSet& states, NodePtr handler);
 	 void add_local_function(const std::string& name, NodePtr block);
+	 /* to be invoked when the construction is finished */
+	 void analyze_private_modifications();
 	 // accessors
 	 bool is_abstract() const;
 	 std::size_t get_id() const;
@@ -147,7 +151,41 @@ namespace Astl {
 	 Iterator get_rules_end() const;
 	 Iterator get_creating_rules_begin() const;
 	 Iterator get_creating_rules_end() const;
+	 /*
+	    rules that may fire at a node of the given type for the
+	    given label in the given state, restricted to the alternatives
+	    that match the label and state; these lists are computed
+	    on first use and kept for all subsequent lookups
+	 */
+	 typedef struct {
+	    StateMachineRulePtr rule;
+	    std::vector<StateMachineRuleAlternativePtr> alternatives;
+	 } Dispatch;
+	 typedef std::vector<Dispatch> DispatchList;
+	 const DispatchList& get_dispatch_list(std::size_t node_type,
+	    std::size_t label_index, int state) const;
+	 /* creating rules that may fire at a node of the given type */
+	 typedef std::vector<StateMachineRulePtr> RuleList;
+	 const RuleList& get_creating_rules(std::size_t node_type) const;
 	 void run_close_handlers(int state, BindingsPtr local_bindings) const;
+	 /* may the execution of a rule modify the private bindings? */
+	 bool modifies_private_bindings(StateMachineRulePtr rule) const;
+	 /* may the close handlers modify the private bindings? */
+	 bool close_handlers_modify_private_bindings() const;
+	 /*
+	    state machines without variables that neither cache
+	    nor retract, whose blocks call builtin functions only,
+	    and whose conditions neither call functions nor reference
+	    global variables behave the same on all paths that reach
+	    a node in the same state -- provided that the attributes
+	    selected by their conditions are not updated by any
+	    state machine (see below)
+	 */
+	 bool is_path_independent() const;
+	 /* do the conditions select attributes or container members? */
+	 bool conditions_select_attributes() const;
+	 /* may the blocks update attributes or container members? */
+	 bool may_update_attributes() const;
       private:
 	 bool abstract;
 	 bool global;
@@ -162,9 +200,16 @@ namespace Astl {
 	 std::list<Variable> shared_var_list;
 	 std::list<Variable> private_var_list;
 	 BindingsPtr bindings;
+	 bool calls_user_functions(NodePtr node) const;
+	 bool calls_user_functions(NodePtr node,
+	    const std::set<std::string>& declared) const;
 	 // list of rules
 	 std::list<StateMachineRulePtr> rules;
 	 std::list<StateMachineRulePtr> creating_rules;
+	 // dispatch tables, indexed by node type, label index, and state
+	 typedef std::vector<std::unique_ptr<DispatchList>> StateDispatch;
+	 mutable std::vector<std::vector<StateDispatch>> dispatch_table;
+	 mutable std::vector<std::unique_ptr<RuleList>> creating_rules_table;
 	 // list of handlers
 	 typedef struct {
 	    StateSet states;
@@ -174,6 +219,9 @@ namespace Astl {
 	 // list of local functions
 	 typedef std::map<std::string, NodePtr> FunctionTable;
 	 FunctionTable local_functions;
+	 // rules which possibly modify private bindings
+	 std::set<StateMachineRulePtr> modifying_rules;
+	 bool modifying_close_handlers;
 	 // non-abstract state machines:
 	 std::size_t id;
 	 std::map<int, std::string> stateByNumber;
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009-2019 Andreas Franz Borchert
+   Copyright (C) 2009-2019, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -23,11 +23,13 @@
 #include <string>
 #include <astl/cloner.hpp>
 #include <astl/exception.hpp>
+#include <astl/flow-graph-analysis.hpp>
 #include <astl/flow-graph.hpp>
 #include <astl/operator.hpp>
 #include <astl/parser.hpp>
 #include <astl/printer.hpp>
 #include <astl/scanner.hpp>
+#include <astl/snapshot.hpp>
 #include <astl/std-functions.hpp>
 #include <astl/types.hpp>
 #include <astl/utf8.hpp>
@@ -140,12 +142,22 @@ AttributePtr builtin_extract_attributes(BindingsPtr bindings,
 }
 
 AttributePtr builtin_gentext(BindingsPtr bindings, AttributePtr args) {
-   if (!args || args->size() != 1) {
+   if (!args || args->size() < 1 || args->size() > 2) {
       throw Exception("wrong number of arguments for gentext function");
    }
+   unsigned int threads = 1;
+   if (args->size() == 2) {
+      AttributePtr threads_at = args->get_value(1);
+      if (!threads_at) {
+	 throw Exception("non-null value expected as second argument "
+	    "of gentext function");
+      }
+      Location loc;
+      threads = threads_at->convert_to_integer(loc)->get_unsigned_int(loc);
+   }
    AttributePtr at = args->get_value(0);
    if (at && at->get_type() == Attribute::tree) {
-      return gen_text(at->get_node(), bindings);
+      return gen_text(at->get_node(), bindings, threads);
    } else {
       throw Exception("abstract syntax tree expected as argument to gentext");
    }
@@ -216,6 +228,17 @@ AttributePtr builtin_len(BindingsPtr bindings, AttributePtr args) {
    }
 }
 
+AttributePtr builtin_load_snapshot(BindingsPtr bindings, AttributePtr args) {
+   if (!args || args->size() != 1) {
+      throw Exception("wrong number of arguments for load_snapshot function");
+   }
+   AttributePtr at = args->get_value(0);
+   if (!at) {
+      throw Exception("null passed to load_snapshot function");
+   }
+   return std::make_shared<Attribute>(read_snapshot(at->convert_to_string()));
+}
+
 AttributePtr builtin_location(BindingsPtr bindings, AttributePtr args) {
    if (!args || args->size() != 1) {
       throw Exception("wrong number of arguments for location function");
@@ -420,6 +443,22 @@ AttributePtr builtin_push(BindingsPtr bindings, AttributePtr args) {
    return list;
 }
 
+AttributePtr builtin_save_snapshot(BindingsPtr bindings, AttributePtr args) {
+   if (!args || args->size() != 2) {
+      throw Exception("wrong number of arguments for save_snapshot function");
+   }
+   AttributePtr tree = args->get_value(0);
+   AttributePtr filename = args->get_value(1);
+   if (!tree || tree->get_type() != Attribute::tree) {
+      throw Exception("tree expected as first argument of save_snapshot");
+   }
+   if (!filename) {
+      throw Exception("null passed as filename to save_snapshot function");
+   }
+   write_snapshot(filename->convert_to_string(), tree->get_node());
+   return AttributePtr(nullptr);
+}
+
 AttributePtr builtin_string(BindingsPtr bindings, AttributePtr args) {
    if (!args || args->size() != 1) {
       throw Exception("wrong number of arguments for string function");
@@ -462,6 +501,18 @@ AttributePtr builtin_tokentext(BindingsPtr bindings, AttributePtr args) {
    }
 }
 
+AttributePtr builtin_treehash(BindingsPtr bindings, AttributePtr args) {
+   if (!args || args->size() != 1) {
+      throw Exception("wrong number of arguments for treehash function");
+   }
+   AttributePtr at = args->get_value(0);
+   if (!at || at->get_type() != Attribute::tree) {
+      throw Exception("tree expected as argument of treehash");
+   }
+   unsigned long hashval = at->get_node()->hash();
+   return std::make_shared<Attribute>(hashval);
+}
+
 AttributePtr builtin_type(BindingsPtr bindings, AttributePtr args) {
    if (!args || args->size() != 1) {
       throw Exception("wrong number of arguments for type function");
@@ -627,7 +678,163 @@ AttributePtr builtin_cfg_type(BindingsPtr bindings, AttributePtr args) {
    return std::make_shared<Attribute>(fgnode->get_type());
 }
 
+// control flow graph analysis functions
+
+static FlowGraphNodePtr get_fgnode_arg(AttributePtr args, std::size_t index,
+      const std::string& fname) {
+   AttributePtr node = args->get_value(index);
+   if (!node || node->get_type() != Attribute::flow_graph_node) {
+      throw Exception("flow graph node expected as argument "
+	 "to " + fname + " function");
+   }
+   return node->get_fgnode();
+}
+
+/* the first argument is always the entry node of the analyzed graph */
+static FlowGraphAnalysisPtr get_analysis(AttributePtr args,
+      std::size_t minargs, std::size_t maxargs, const std::string& fname) {
+   if (!args || args->size() < minargs || args->size() > maxargs) {
+      throw Exception("wrong number of arguments for " + fname + " function");
+   }
+   return FlowGraphAnalysis::get(get_fgnode_arg(args, 0, fname));
+}
+
+static AttributePtr fgnode_result(FlowGraphNodePtr fgnode) {
+   if (!fgnode) return AttributePtr(nullptr);
+   return std::make_shared<Attribute>(fgnode);
+}
+
+static AttributePtr fgnode_list(const std::vector<FlowGraphNodePtr>& fgnodes) {
+   AttributePtr list = std::make_shared<Attribute>(Attribute::list);
+   for (auto& fgnode: fgnodes) {
+      list->push_back(std::make_shared<Attribute>(fgnode));
+   }
+   return list;
+}
+
+/* optional set of nodes to be avoided: a node or a list of nodes */
+static void get_avoidance_arg(AttributePtr args, std::size_t index,
+      const std::string& fname, std::vector<FlowGraphNodePtr>& avoid) {
+   if (args->size() <= index) return;
+   AttributePtr at = args->get_value(index);
+   if (!at) return;
+   if (at->get_type() == Attribute::flow_graph_node) {
+      avoid.push_back(at->get_fgnode());
+   } else if (at->get_type() == Attribute::list) {
+      for (std::size_t i = 0; i < at->size(); ++i) {
+	 AttributePtr member = at->get_value(i);
+	 if (!member || member->get_type() != Attribute::flow_graph_node) {
+	    throw Exception("list of flow graph nodes expected as argument "
+	       "to " + fname + " function");
+	 }
+	 avoid.push_back(member->get_fgnode());
+      }
+   } else {
+      throw Exception("flow graph node or list expected as argument "
+	 "to " + fname + " function");
+   }
+}
+
+AttributePtr builtin_cfg_idom(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_idom");
+   return fgnode_result(analysis->get_idom(
+      get_fgnode_arg(args, 1, "cfg_idom")));
+}
+
+AttributePtr builtin_cfg_dominates(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 3, 3, "cfg_dominates");
+   return std::make_shared<Attribute>(analysis->dominates(
+      get_fgnode_arg(args, 1, "cfg_dominates"),
+      get_fgnode_arg(args, 2, "cfg_dominates")));
+}
+
+AttributePtr builtin_cfg_ipdom(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_ipdom");
+   return fgnode_result(analysis->get_ipdom(
+      get_fgnode_arg(args, 1, "cfg_ipdom")));
+}
+
+AttributePtr builtin_cfg_postdominates(BindingsPtr bindings,
+      AttributePtr args) {
+   auto analysis = get_analysis(args, 3, 3, "cfg_postdominates");
+   return std::make_shared<Attribute>(analysis->postdominates(
+      get_fgnode_arg(args, 1, "cfg_postdominates"),
+      get_fgnode_arg(args, 2, "cfg_postdominates")));
+}
+
+AttributePtr builtin_cfg_frontier(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_frontier");
+   std::vector<FlowGraphNodePtr> frontier;
+   analysis->get_frontier(get_fgnode_arg(args, 1, "cfg_frontier"), frontier);
+   return fgnode_list(frontier);
+}
+
+AttributePtr builtin_cfg_loop_header(BindingsPtr bindings,
+      AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_loop_header");
+   return fgnode_result(analysis->get_loop_header(
+      get_fgnode_arg(args, 1, "cfg_loop_header")));
+}
+
+AttributePtr builtin_cfg_loop_parent(BindingsPtr bindings,
+      AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_loop_parent");
+   return fgnode_result(analysis->get_loop_parent(
+      get_fgnode_arg(args, 1, "cfg_loop_parent")));
+}
+
+AttributePtr builtin_cfg_loop_depth(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_loop_depth");
+   return std::make_shared<Attribute>(analysis->get_loop_depth(
+      get_fgnode_arg(args, 1, "cfg_loop_depth")));
+}
+
+AttributePtr builtin_cfg_reaches(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 3, 4, "cfg_reaches");
+   std::vector<FlowGraphNodePtr> avoid;
+   get_avoidance_arg(args, 3, "cfg_reaches", avoid);
+   return std::make_shared<Attribute>(analysis->reaches(
+      get_fgnode_arg(args, 1, "cfg_reaches"),
+      get_fgnode_arg(args, 2, "cfg_reaches"), avoid));
+}
+
+AttributePtr builtin_cfg_reachable(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 3, "cfg_reachable");
+   std::vector<FlowGraphNodePtr> avoid;
+   get_avoidance_arg(args, 2, "cfg_reachable", avoid);
+   std::vector<FlowGraphNodePtr> reachable;
+   analysis->get_reachable(get_fgnode_arg(args, 1, "cfg_reachable"),
+      avoid, reachable);
+   return fgnode_list(reachable);
+}
+
+AttributePtr builtin_cfg_scc(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 2, 2, "cfg_scc");
+   std::size_t component;
+   if (!analysis->get_component(get_fgnode_arg(args, 1, "cfg_scc"),
+	 component)) {
+      return AttributePtr(nullptr);
+   }
+   return std::make_shared<Attribute>(component);
+}
+
+AttributePtr builtin_cfg_components(BindingsPtr bindings, AttributePtr args) {
+   auto analysis = get_analysis(args, 1, 1, "cfg_components");
+   AttributePtr list = std::make_shared<Attribute>(Attribute::list);
+   std::vector<FlowGraphNodePtr> members;
+   for (std::size_t c = 0; c < analysis->get_number_of_components(); ++c) {
+      analysis->get_component_nodes(c, members);
+      list->push_back(fgnode_list(members));
+   }
+   return list;
+}
+
 void insert_std_functions(BuiltinFunctions& bfs) {
+   insert_shared_std_functions(bfs);
+   insert_local_std_functions(bfs);
+}
+
+void insert_shared_std_functions(BuiltinFunctions& bfs) {
    bfs.add("assert", builtin_assert);
    bfs.add("chr", builtin_chr);
    bfs.add("clone", builtin_clone);
@@ -636,12 +843,12 @@ void insert_std_functions(BuiltinFunctions& bfs) {
    bfs.add("defined", builtin_defined);
    bfs.add("exit", builtin_exit);
    bfs.add("extract_attributes", builtin_extract_attributes);
-   bfs.add("gentext", builtin_gentext);
    bfs.add("getline", builtin_getline);
    bfs.add("integer", builtin_integer);
    bfs.add("isoperator", builtin_isoperator);
    bfs.add("isstring", builtin_isstring);
    bfs.add("len", builtin_len);
+   bfs.add("load_snapshot", builtin_load_snapshot);
    bfs.add("location", builtin_location);
    bfs.add("make_node", builtin_make_node);
    bfs.add("make_token", builtin_make_token);
@@ -652,16 +859,34 @@ void insert_std_functions(BuiltinFunctions& bfs) {
    bfs.add("println", builtin_println);
    bfs.add("prints", builtin_prints);
    bfs.add("push", builtin_push);
+   bfs.add("save_snapshot", builtin_save_snapshot);
    bfs.add("string", builtin_string);
    bfs.add("tokenliteral", builtin_tokenliteral);
    bfs.add("tokentext", builtin_tokentext);
+   bfs.add("treehash", builtin_treehash);
    bfs.add("type", builtin_type);
    bfs.add("utf8_byte", builtin_utf8_byte);
    bfs.add("utf8_len", builtin_utf8_len);
    // control flow graph extensions
+   bfs.add("cfg_components", builtin_cfg_components);
    bfs.add("cfg_connect", builtin_cfg_connect);
-   bfs.add("cfg_node", builtin_cfg_node);
+   bfs.add("cfg_dominates", builtin_cfg_dominates);
+   bfs.add("cfg_frontier", builtin_cfg_frontier);
+   bfs.add("cfg_idom", builtin_cfg_idom);
+   bfs.add("cfg_ipdom", builtin_cfg_ipdom);
+   bfs.add("cfg_loop_depth", builtin_cfg_loop_depth);
+   bfs.add("cfg_loop_header", builtin_cfg_loop_header);
+   bfs.add("cfg_loop_parent", builtin_cfg_loop_parent);
+   bfs.add("cfg_postdominates", builtin_cfg_postdominates);
+   bfs.add("cfg_reachable", builtin_cfg_reachable);
+   bfs.add("cfg_reaches", builtin_cfg_reaches);
+   bfs.add("cfg_scc", builtin_cfg_scc);
    bfs.add("cfg_type", builtin_cfg_type);
 }
 
+void insert_local_std_functions(BuiltinFunctions& bfs) {
+   bfs.add("cfg_node", builtin_cfg_node);
+   bfs.add("gentext", builtin_gentext);
+}
+
 } // namespace Astl
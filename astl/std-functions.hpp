@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -23,7 +23,15 @@
 
 namespace Astl {
 
+   /* all standard functions */
    void insert_std_functions(BuiltinFunctions& bfs);
+   /* standard functions which do not depend on the global
+      bindings they are defined in and which can therefore
+      be shared by all runs */
+   void insert_shared_std_functions(BuiltinFunctions& bfs);
+   /* standard functions which need the global bindings of a run,
+      i.e. its graph or its rules */
+   void insert_local_std_functions(BuiltinFunctions& bfs);
 
 } // namespace Astl
 
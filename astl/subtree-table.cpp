@@ -0,0 +1,256 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+#include <astl/subtree-table.hpp>
+
+namespace Astl {
+
+static inline std::size_t combine_hash(std::size_t h1, std::size_t h2) {
+   return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+}
+
+/* token strings and operator names without opcode are interned,
+   i.e. they can be compared and hashed by their addresses */
+
+static std::size_t shallow_hash(const Node& node) {
+   std::hash<const void*> hash;
+   std::size_t h;
+   if (node.is_leaf()) {
+      const Token& token(node.get_token());
+      h = combine_hash(1, token.has_tokenval()? token.get_tokenval(): 0);
+      h = combine_hash(h, hash(&token.get_text()));
+      h = combine_hash(h, hash(&token.get_literal()));
+   } else {
+      Operator op(node.get_op());
+      h = combine_hash(2, op.get_opcode());
+      if (op.get_opcode() == 0) {
+	 h = combine_hash(h, hash(op.get_name()));
+      }
+      for (std::size_t i = 0; i < node.size(); ++i) {
+	 h = combine_hash(h, hash(node.get_operand(i).get()));
+      }
+   }
+   return h;
+}
+
+static bool same_position(const Position& pos1, const Position& pos2) {
+   if (pos1.get_line() != pos2.get_line() ||
+	 pos1.get_column() != pos2.get_column() ||
+	 pos1.is_filename_defined() != pos2.is_filename_defined()) {
+      return false;
+   }
+   /* filenames are interned as well */
+   return !pos1.is_filename_defined() ||
+      &pos1.get_filename() == &pos2.get_filename();
+}
+
+static bool same_location(const Location& loc1, const Location& loc2) {
+   return same_position(loc1.get_begin(), loc2.get_begin()) &&
+      same_position(loc1.get_end(), loc2.get_end());
+}
+
+/* visit all nodes of the tree in preorder including
+   all occurrences of shared subtrees */
+template<typename Visitor>
+static void visit_preorder(const NodePtr& root, Visitor visit) {
+   std::vector<const Node*> stack;
+   stack.push_back(root.get());
+   while (stack.size() > 0) {
+      const Node* node = stack.back(); stack.pop_back();
+      visit(*node);
+      if (node->is_leaf()) continue;
+      for (std::size_t i = node->size(); i > 0; --i) {
+	 stack.push_back(node->get_operand(i - 1).get());
+      }
+   }
+}
+
+static bool shallow_equality(const Node& node1, const Node& node2) {
+   if (node1.is_leaf() != node2.is_leaf()) return false;
+   if (node1.is_leaf()) {
+      const Token& token1(node1.get_token());
+      const Token& token2(node2.get_token());
+      if (token1.has_tokenval() != token2.has_tokenval()) return false;
+      if (token1.has_tokenval() &&
+	    token1.get_tokenval() != token2.get_tokenval()) {
+	 return false;
+      }
+      return &token1.get_text() == &token2.get_text() &&
+	 &token1.get_literal() == &token2.get_literal();
+   }
+   Operator op1(node1.get_op()); Operator op2(node2.get_op());
+   if (op1.get_opcode() != op2.get_opcode()) return false;
+   if (op1.get_opcode() == 0 && op1.get_name() != op2.get_name()) {
+      return false;
+   }
+   if (node1.size() != node2.size()) return false;
+   for (std::size_t i = 0; i < node1.size(); ++i) {
+      if (node1.get_operand(i) != node2.get_operand(i)) return false;
+   }
+   return true;
+}
+
+// occurrence locations ======================================================
+
+const Location& OccurrenceLocations::get_location(std::size_t index,
+      const Node& node) const {
+   auto it = std::lower_bound(locations.begin(), locations.end(), index,
+      [](const std::pair<std::size_t, Location>& entry, std::size_t index) {
+	 return entry.first < index;
+      });
+   if (it != locations.end() && it->first == index) return it->second;
+   return node.get_location();
+}
+
+// subtree table =============================================================
+
+SubtreeTable::SubtreeTable() : sweep_threshold(1024) {
+}
+
+NodePtr SubtreeTable::share(NodePtr node) {
+   std::lock_guard<std::mutex> lock(mutex);
+   return lookup(node);
+}
+
+NodePtr SubtreeTable::lookup(NodePtr node) {
+   if (node->is_shared() || node->has_attributes()) return node;
+   std::size_t h = shallow_hash(*node);
+   auto range = nodes.equal_range(h);
+   for (auto it = range.first; it != range.second; ++it) {
+      NodePtr candidate = it->second.lock();
+      if (candidate && !candidate->has_attributes() &&
+	    shallow_equality(*candidate, *node)) {
+	 /* the node is marked as shared as soon as
+	    it is handed out for another occurrence */
+	 if (candidate != node) candidate->shared = true;
+	 return candidate;
+      }
+   }
+   if (nodes.size() >= sweep_threshold) {
+      for (auto it = nodes.begin(); it != nodes.end();) {
+	 if (it->second.expired()) {
+	    it = nodes.erase(it);
+	 } else {
+	    ++it;
+	 }
+      }
+      sweep_threshold = std::max(sweep_threshold, 2 * nodes.size());
+   }
+   nodes.emplace(h, node);
+   return node;
+}
+
+NodePtr SubtreeTable::share_tree(NodePtr root) {
+   /* collect the unshared operator nodes such that
+      all subnodes precede their parents */
+   std::vector<Node*> parents;
+   std::vector<Node*> stack;
+   stack.push_back(root.get());
+   while (stack.size() > 0) {
+      Node* node = stack.back(); stack.pop_back();
+      if (node->is_leaf() || node->is_shared()) continue;
+      parents.push_back(node);
+      for (std::size_t i = 0; i < node->size(); ++i) {
+	 stack.push_back(node->get_operand(i).get());
+      }
+   }
+   std::lock_guard<std::mutex> lock(mutex);
+   for (auto it = parents.rbegin(); it != parents.rend(); ++it) {
+      Node* node = *it;
+      for (std::size_t i = 0; i < node->size(); ++i) {
+	 const NodePtr& subnode(static_cast<const Node*>(node)->
+	    get_operand(i));
+	 NodePtr shared = lookup(subnode);
+	 if (shared != subnode) {
+	    /* modified() is bypassed as the structural hash values
+	       cached by Node::hash() for node and its ancestors
+	       remain valid: shared is structurally equal to subnode;
+	       node itself has not been entered into the table yet
+	       as its operands would be shared already otherwise */
+	    node->get_operand(i) = shared;
+	 }
+      }
+   }
+   return lookup(root);
+}
+
+/* sharing does not change the order of the preorder traversal,
+   hence the locations can be compared afterwards */
+NodePtr SubtreeTable::share_tree(NodePtr root,
+      OccurrenceLocations& locations) {
+   std::vector<Location> original;
+   visit_preorder(root, [&](const Node& node) {
+      original.push_back(node.get_location());
+   });
+   root = share_tree(root);
+   locations.locations.clear();
+   std::size_t index = 0;
+   visit_preorder(root, [&](const Node& node) {
+      if (!same_location(node.get_location(), original[index])) {
+	 locations.locations.emplace_back(index, original[index]);
+      }
+      ++index;
+   });
+   return root;
+}
+
+// process-wide table =======================================================
+
+static std::atomic<bool>& sharing_flag() {
+   static std::atomic<bool> flag([]() {
+      const char* value = std::getenv("ASTL_SHARE_SUBTREES");
+      return value != nullptr && *value != 0;
+   }());
+   return flag;
+}
+
+bool subtree_sharing_enabled() {
+   return sharing_flag();
+}
+
+void enable_subtree_sharing(bool enable) {
+   sharing_flag() = enable;
+}
+
+static SubtreeTable& get_subtree_table() {
+   static SubtreeTable table;
+   return table;
+}
+
+NodePtr share_subtree(NodePtr node) {
+   if (!subtree_sharing_enabled()) return node;
+   return get_subtree_table().share(node);
+}
+
+NodePtr share_subtrees(NodePtr root) {
+   if (!subtree_sharing_enabled()) return root;
+   return get_subtree_table().share_tree(root);
+}
+
+NodePtr share_subtrees(NodePtr root, OccurrenceLocations& locations) {
+   if (!subtree_sharing_enabled()) return root;
+   return get_subtree_table().share_tree(root, locations);
+}
+
+} // namespace Astl
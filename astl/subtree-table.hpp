@@ -0,0 +1,110 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_SUBTREE_TABLE_H
+#define ASTL_SUBTREE_TABLE_H
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <astl/syntax-tree.hpp>
+#include <astl/treeloc.hpp>
+
+namespace Astl {
+
+   /**
+    * Locations of the occurrences of shared subtrees which differ
+    * from those of the shared nodes, i.e. from those of their first
+    * occurrences. Occurrences are identified by their index in the
+    * preorder traversal of the tree where all occurrences of a shared
+    * subtree are visited, starting with 0 for the root.
+    */
+   class OccurrenceLocations {
+      public:
+	 /** return the location of the occurrence with the given
+	     index which is represented by node */
+	 const Location& get_location(std::size_t index,
+	    const Node& node) const;
+
+      private:
+	 std::vector<std::pair<std::size_t, Location>> locations;
+	    // sorted by the index
+	 friend class SubtreeTable;
+   };
+   typedef std::shared_ptr<OccurrenceLocations> OccurrenceLocationsPtr;
+
+   /**
+    * Hash-consing of syntax trees: structurally equal subtrees
+    * are represented by one shared node.
+    *
+    * Two nodes are considered equal by the table if they are
+    * leaves with the same token (symbol, text, and literal) or
+    * operator nodes with the same operator and identical subnodes.
+    * Hence, share() expects the subnodes of a node to be shared
+    * already while share_tree() shares an entire tree bottom-up.
+    *
+    * Nodes with attributes are never shared, and nodes
+    * are no longer handed out once attributes have been added to
+    * them. The location of a shared node is that of its first
+    * occurrence; the locations of the other occurrences may be
+    * kept separately (see OccurrenceLocations). Nodes are marked
+    * as shared (see Node::is_shared()) when they are returned for
+    * another occurrence and must not be modified from then on.
+    * The table refers to its nodes weakly, i.e. it does not keep
+    * them alive.
+    */
+   class SubtreeTable {
+      public:
+	 SubtreeTable();
+
+	 /** return a shared node that is equal to node */
+	 NodePtr share(NodePtr node);
+	 /** share all subtrees of root bottom-up */
+	 NodePtr share_tree(NodePtr root);
+	 /** likewise but the locations that get lost are recorded */
+	 NodePtr share_tree(NodePtr root, OccurrenceLocations& locations);
+
+      private:
+	 std::mutex mutex;
+	 std::unordered_multimap<std::size_t, std::weak_ptr<Node>> nodes;
+	 std::size_t sweep_threshold; // drop expired entries beyond this
+	 NodePtr lookup(NodePtr node);
+   };
+
+   /*
+      Subtree sharing is opt-in: it is enabled if the environment
+      variable ASTL_SHARE_SUBTREES is set to a non-empty value
+      or if it has been enabled explicitly. If enabled, the abstract
+      syntax tree is shared through a process-wide table once its
+      attributes are set, i.e. before mutations are generated.
+   */
+   bool subtree_sharing_enabled();
+   void enable_subtree_sharing(bool enable = true);
+
+   /* share node or the entire tree of root, respectively,
+      if subtree sharing is enabled; return it unchanged otherwise */
+   NodePtr share_subtree(NodePtr node);
+   NodePtr share_subtrees(NodePtr root);
+   NodePtr share_subtrees(NodePtr root, OccurrenceLocations& locations);
+
+} // namespace Astl
+
+#endif
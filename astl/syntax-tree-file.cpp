@@ -0,0 +1,402 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <astl/binary-coding.hpp>
+#include <astl/exception.hpp>
+#include <astl/intern.hpp>
+#include <astl/syntax-tree-file.hpp>
+
+namespace Astl {
+
+static const char magic[] = "ASTLAST1";
+static constexpr std::size_t magic_len = 8;
+
+enum {ref_tag = 0, leaf_tag = 1, operator_tag = 2};
+enum {same_filename = 0, no_filename = 1, new_filename = 2};
+
+namespace {
+
+   /* last position relative to which the next one is encoded */
+   struct PositionState {
+      std::size_t filename; // string index, npos if undefined
+      std::uint64_t line;
+      std::uint64_t column;
+   };
+
+   const std::size_t npos = ~std::size_t(0);
+   const PositionState initial_state = {npos, 0, 0};
+
+} // anonymous namespace
+
+// writer ===================================================================
+
+static void encode_position(BinaryEncoder& enc, BinaryStringTable& strings,
+      const Position& pos, PositionState& state) {
+   std::size_t filename = npos;
+   if (pos.is_filename_defined()) {
+      filename = strings.add_filename(pos.get_filename());
+   }
+   unsigned int f;
+   if (filename == state.filename) {
+      f = same_filename;
+   } else if (filename == npos) {
+      f = no_filename;
+   } else {
+      f = new_filename;
+   }
+   std::int64_t line_delta = std::int64_t(pos.get_line() - state.line);
+   enc.put(3 * zigzag(line_delta) + f);
+   if (f == new_filename) enc.put(filename);
+   if (line_delta == 0) {
+      enc.put_signed(std::int64_t(pos.get_column() - state.column));
+   } else {
+      enc.put(pos.get_column());
+   }
+   state = PositionState{filename, pos.get_line(), pos.get_column()};
+}
+
+static void write_syntax_tree(std::ostream& out, NodePtr root,
+      const std::string& signature, std::vector<const Node*>& nodes) {
+   if (!root) {
+      throw Exception("no syntax tree to be written");
+   }
+   BinaryStringTable strings;
+   typedef std::pair<unsigned int, std::string> OperatorKey;
+   std::map<OperatorKey, std::size_t> operators;
+   std::vector<OperatorKey> optab;
+   BinaryEncoder structure, tokens, locations;
+   PositionState last_begin = initial_state;
+   std::size_t count = 0;
+   /* only nodes with more than one owner may be shared */
+   std::unordered_map<const Node*, std::size_t> shared_ids;
+   std::vector<const NodePtr*> stack;
+   stack.push_back(&root);
+   while (stack.size() > 0) {
+      const NodePtr& nodeptr = *stack.back(); stack.pop_back();
+      if (!nodeptr) {
+	 throw Exception("syntax tree with null subnodes cannot be written");
+      }
+      const Node* node = nodeptr.get();
+      if (nodeptr.use_count() > 1) {
+	 auto it = shared_ids.find(node);
+	 if (it != shared_ids.end()) {
+	    structure.put(ref_tag); structure.put(it->second);
+	    continue;
+	 }
+	 shared_ids[node] = count;
+      }
+      ++count; nodes.push_back(node);
+      const Location& loc = node->get_location();
+      encode_position(locations, strings, loc.get_begin(), last_begin);
+      PositionState state = last_begin;
+      encode_position(locations, strings, loc.get_end(), state);
+      if (node->is_leaf()) {
+	 structure.put(leaf_tag);
+	 const Token& token = node->get_token();
+	 tokens.put(token.has_tokenval()? token.get_tokenval(): 0);
+	 std::size_t text = strings.add(token.get_text());
+	 tokens.put(text);
+	 if (token.get_literal() == token.get_text()) {
+	    tokens.put(0);
+	 } else {
+	    tokens.put(strings.add(token.get_literal()) + 1);
+	 }
+      } else {
+	 Operator op = node->get_op();
+	 OperatorKey key(op.get_opcode(), op.get_name());
+	 if (key.second.empty()) {
+	    throw Exception("syntax tree with unnamed operators "
+	       "cannot be written");
+	 }
+	 auto it = operators.find(key);
+	 if (it == operators.end()) {
+	    it = operators.insert(std::make_pair(key, optab.size())).first;
+	    optab.push_back(key);
+	 }
+	 structure.put(operator_tag + it->second);
+	 structure.put(node->size());
+	 for (std::size_t i = node->size(); i > 0; --i) {
+	    stack.push_back(&node->get_operand(i - 1));
+	 }
+      }
+   }
+   /* the operator table refers to the string table */
+   BinaryEncoder ops;
+   ops.put(optab.size());
+   for (auto& key: optab) {
+      ops.put(key.first);
+      ops.put(strings.add(key.second));
+   }
+   BinaryEncoder enc;
+   enc.put_raw(magic, magic_len);
+   enc.put(signature);
+   strings.encode(enc);
+   enc.put_raw(ops.get_buffer().data(), ops.get_buffer().size());
+   enc.put(count);
+   for (auto section: {&structure, &tokens, &locations}) {
+      const std::string& buf = section->get_buffer();
+      enc.put(buf.size());
+      enc.put_raw(buf.data(), buf.size());
+   }
+   const std::string& buf = enc.get_buffer();
+   out.write(buf.data(), buf.size());
+}
+
+void write_syntax_tree(std::ostream& out, NodePtr root,
+      std::vector<const Node*>& nodes) {
+   write_syntax_tree(out, root, "", nodes);
+}
+
+void write_syntax_tree(std::ostream& out, NodePtr root,
+      const std::string& signature) {
+   std::vector<const Node*> nodes;
+   write_syntax_tree(out, root, signature, nodes);
+}
+
+void write_syntax_tree(std::ostream& out, NodePtr root) {
+   write_syntax_tree(out, root, "");
+}
+
+void write_syntax_tree(const std::string& path, NodePtr root) {
+   write_syntax_tree(path, root, "");
+}
+
+void write_syntax_tree(const std::string& path, NodePtr root,
+      const std::string& signature) {
+   std::ofstream out(path, std::ios::binary);
+   if (out) {
+      write_syntax_tree(out, root, signature);
+      out.close();
+   }
+   if (!out) {
+      std::ostringstream os;
+      os << "unable to write syntax tree to " << path;
+      throw Exception(os.str());
+   }
+}
+
+// reader ===================================================================
+
+static Position decode_position(BinaryDecoder& dec,
+      const std::vector<std::string>& strings, PositionState& state) {
+   std::uint64_t header = dec.get();
+   std::int64_t line_delta = unzigzag(header / 3);
+   switch (header % 3) {
+      case same_filename:
+	 break;
+      case no_filename:
+	 state.filename = npos; break;
+      default:
+	 state.filename = dec.get_index(strings.size()); break;
+   }
+   state.line += line_delta;
+   if (line_delta == 0) {
+      state.column += dec.get_signed();
+   } else {
+      state.column = dec.get();
+   }
+   const std::string* filename = nullptr;
+   if (state.filename != npos) {
+      filename = &strings[state.filename];
+   }
+   return Position(filename, state.line, state.column);
+}
+
+/* signatures are checked separately as a mismatch is not
+   an indication of a corrupted file */
+static bool check_signature(BinaryDecoder& dec, const std::string& signature) {
+   if (std::memcmp(dec.get_raw(magic_len), magic, magic_len) != 0) {
+      throw MalformedBinaryData();
+   }
+   return dec.get_string() == signature;
+}
+
+static NodePtr decode_tree(BinaryDecoder& dec, std::vector<NodePtr>& nodes) {
+   std::vector<std::string> strings(dec.get_count(1));
+   for (auto& s: strings) {
+      s = dec.get_string();
+   }
+   std::vector<Operator> optab(dec.get_count(2));
+   for (auto& op: optab) {
+      unsigned int opcode = dec.get();
+      const std::string& name = strings[dec.get_index(strings.size())];
+      if (name.empty()) throw MalformedBinaryData();
+      if (opcode > 0) {
+	 op = Operator(opcode, intern_opname(name));
+      } else {
+	 op = Operator(name);
+      }
+   }
+   std::size_t count = dec.get();
+   BinaryDecoder structure = dec.get_section(dec.get());
+   BinaryDecoder tokens = dec.get_section(dec.get());
+   BinaryDecoder locations = dec.get_section(dec.get());
+   /* each node takes at least one byte of the structure section */
+   if (count > structure.remaining()) throw MalformedBinaryData();
+
+   nodes.clear(); nodes.reserve(count);
+   struct Frame {
+      Node* node;
+      std::size_t index; // preorder number
+      std::size_t remaining; // number of subnodes yet to be added
+   };
+   /* references are permitted to completed subtrees only
+      as everything else would create cycles */
+   std::vector<bool> complete; complete.reserve(count);
+   std::vector<Frame> stack;
+   PositionState last_begin = initial_state;
+   NodePtr root;
+   do {
+      NodePtr node;
+      std::size_t arity = 0;
+      std::uint64_t tag = structure.get();
+      if (tag == ref_tag) {
+	 std::size_t index = structure.get_index(nodes.size());
+	 if (!complete[index]) throw MalformedBinaryData();
+	 node = nodes[index];
+      } else {
+	 if (nodes.size() == count) throw MalformedBinaryData();
+	 Position begin = decode_position(locations, strings, last_begin);
+	 PositionState state = last_begin;
+	 Position end = decode_position(locations, strings, state);
+	 Location loc(begin, end);
+	 if (tag == leaf_tag) {
+	    unsigned int symbol = tokens.get();
+	    std::size_t text_index = tokens.get_index(strings.size());
+	    std::size_t literal = tokens.get_index(strings.size() + 1);
+	    const std::string& text = strings[text_index];
+	    const std::string& lit = literal? strings[literal - 1]: text;
+	    if (symbol > 0) {
+	       node = std::make_shared<Node>(loc, Token(symbol, text, lit));
+	    } else {
+	       Token token(text); token.set_literal(lit);
+	       node = std::make_shared<Node>(loc, token);
+	    }
+	 } else {
+	    if (tag - operator_tag >= optab.size()) {
+	       throw MalformedBinaryData();
+	    }
+	    node = std::make_shared<Node>(loc, optab[tag - operator_tag]);
+	    arity = structure.get();
+	 }
+	 nodes.push_back(node); complete.push_back(arity == 0);
+      }
+      if (stack.size() > 0) {
+	 *stack.back().node += node; --stack.back().remaining;
+      } else if (!root) {
+	 root = node;
+      } else {
+	 throw MalformedBinaryData();
+      }
+      if (arity > 0) {
+	 stack.push_back(Frame{node.get(), nodes.size() - 1, arity});
+      } else {
+	 while (stack.size() > 0 && stack.back().remaining == 0) {
+	    complete[stack.back().index] = true;
+	    stack.pop_back();
+	 }
+      }
+   } while (stack.size() > 0);
+   if (nodes.size() != count || !structure.at_end() ||
+	 !tokens.at_end() || !locations.at_end()) {
+      throw MalformedBinaryData();
+   }
+   return root;
+}
+
+static NodePtr read_syntax_tree(const char* begin, std::size_t len,
+      const std::string& signature, std::vector<NodePtr>& nodes) {
+   try {
+      BinaryDecoder dec(begin, begin + len);
+      if (!check_signature(dec, signature)) {
+	 throw Exception("syntax tree of another front end");
+      }
+      NodePtr root = decode_tree(dec, nodes);
+      if (!dec.at_end()) throw MalformedBinaryData();
+      return root;
+   } catch (MalformedBinaryData&) {
+      throw Exception("malformed syntax tree");
+   }
+}
+
+NodePtr read_syntax_tree(const char* begin, std::size_t len,
+      std::vector<NodePtr>& nodes) {
+   return read_syntax_tree(begin, len, "", nodes);
+}
+
+NodePtr read_syntax_tree(const char* begin, std::size_t len,
+      const std::string& signature) {
+   std::vector<NodePtr> nodes;
+   return read_syntax_tree(begin, len, signature, nodes);
+}
+
+NodePtr read_syntax_tree(const char* begin, std::size_t len) {
+   return read_syntax_tree(begin, len, "");
+}
+
+NodePtr read_syntax_tree(const std::string& path,
+      const std::string& signature) {
+   MappedFile file(path);
+   try {
+      BinaryDecoder dec(file.begin(), file.begin() + file.size());
+      if (!check_signature(dec, signature)) {
+	 std::ostringstream os;
+	 os << path << " has been written by another front end";
+	 throw Exception(os.str());
+      }
+      std::vector<NodePtr> nodes;
+      NodePtr root = decode_tree(dec, nodes);
+      if (!dec.at_end()) throw MalformedBinaryData();
+      return root;
+   } catch (MalformedBinaryData&) {
+      std::ostringstream os;
+      os << path << " is not a valid syntax tree file";
+      throw Exception(os.str());
+   }
+}
+
+NodePtr read_syntax_tree(const std::string& path) {
+   return read_syntax_tree(path, "");
+}
+
+// generator ================================================================
+
+SyntaxTreeFileReader::SyntaxTreeFileReader() {
+}
+
+SyntaxTreeFileReader::SyntaxTreeFileReader(const std::string& signature) :
+      signature(signature) {
+}
+
+NodePtr SyntaxTreeFileReader::gen(int& argc, char**& argv) {
+   if (argc == 0) {
+      throw Exception("no syntax tree file given");
+   }
+   char* path = *argv++; --argc;
+   return read_syntax_tree(path, signature);
+}
+
+} // namespace Astl
@@ -0,0 +1,123 @@
+/*
+   Copyright (C) 2026 Andreas F. Borchert
+   ----------------------------------------------------------------------------
+   The Astl Library is free software; you can redistribute it
+   and/or modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either version
+   2 of the License, or (at your option) any later version.
+
+   The Astl Library is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef ASTL_SYNTAX_TREE_FILE_H
+#define ASTL_SYNTAX_TREE_FILE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <astl/generator.hpp>
+#include <astl/syntax-tree.hpp>
+
+namespace Astl {
+
+   /*
+      Binary interchange format for syntax trees which permits
+      front ends to store a tree once and to run any number of
+      scripts on it later without parsing the sources again.
+      All integers are encoded as varints (see binary-coding.hpp):
+
+	 magic ("ASTLAST1", 8 bytes)
+	 signature of the front end (length and bytes)
+	 string table: number of strings, strings
+	 operator table: number of operators,
+	    for each operator its opcode and its name (string index)
+	 number of nodes
+	 structure section, token section, location section,
+	    each of them preceded by its length in bytes
+
+      The sections list the nodes in preorder. Subtrees which are
+      shared within a tree are stored just once and referred to
+      by the preorder number of their root. For each node, the
+      structure section holds
+
+	 0, followed by the preorder number of a shared subtree, or
+	 1 for a leaf, or
+	 2 + k for an operator node with operator k of the
+	    operator table, followed by the number of its subnodes.
+
+      For each leaf (but not for references), the token section
+      holds its symbol value (0 if none), its text (string index),
+      and its literal (0 if it equals the text, string index + 1
+      otherwise).
+
+      For each node (but not for references), the location section
+      holds the begin and end position. The begin position is encoded
+      relative to the begin position of the preceding node, the end
+      position relative to the begin position of the same node:
+
+	 3 * zigzag(line delta) + f, where f is 0 if the filename
+	    remains unchanged, 1 if it is undefined, and 2 if
+	    a new filename (string index) follows,
+	 [filename], and
+	 zigzag(column delta), if the line remains unchanged,
+	    the column otherwise.
+
+      Attributes are not part of the format.
+
+      Token symbols and opcodes are meaningful for the grammar
+      of the front end only which has created the tree. Hence,
+      front ends pass a signature which identifies their grammar
+      (e.g. a hash of the token and operator names of their
+      parser) and trees are read only if the signatures match.
+      The variants without signature use an empty signature.
+   */
+
+   /** write a syntax tree in the binary interchange format */
+   void write_syntax_tree(std::ostream& out, NodePtr root);
+   void write_syntax_tree(std::ostream& out, NodePtr root,
+      const std::string& signature);
+   void write_syntax_tree(const std::string& path, NodePtr root);
+   void write_syntax_tree(const std::string& path, NodePtr root,
+      const std::string& signature);
+
+   /** read a syntax tree that has been written by write_syntax_tree() */
+   NodePtr read_syntax_tree(const char* begin, std::size_t len);
+   NodePtr read_syntax_tree(const char* begin, std::size_t len,
+      const std::string& signature);
+   /** the file is mapped into memory and decoded in place */
+   NodePtr read_syntax_tree(const std::string& path);
+   NodePtr read_syntax_tree(const std::string& path,
+      const std::string& signature);
+
+   /* variants which deliver all nodes indexed by their preorder
+      numbers, permitting other formats to refer to them */
+   void write_syntax_tree(std::ostream& out, NodePtr root,
+      std::vector<const Node*>& nodes);
+   NodePtr read_syntax_tree(const char* begin, std::size_t len,
+      std::vector<NodePtr>& nodes);
+
+   /**
+    * Syntax tree generator which takes the next argument as the
+    * name of a file in the binary interchange format. This permits
+    * a tree to be generated by a front end once and to be
+    * analyzed repeatedly by run().
+    */
+   class SyntaxTreeFileReader: public SyntaxTreeGenerator {
+      public:
+	 SyntaxTreeFileReader();
+	 SyntaxTreeFileReader(const std::string& signature);
+	 virtual NodePtr gen(int& argc, char**& argv);
+      private:
+	 std::string signature;
+   };
+
+} // namespace Astl
+
+#endif
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2016 Andreas F. Borchert
+   Copyright (C) 2009, 2016, 2026 Andreas F. Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -16,107 +16,125 @@
    Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
+#include <atomic>
 #include <cassert>
+#include <functional>
 #include <memory>
+#include <unordered_set>
 #include <astl/attribute.hpp>
 #include <astl/syntax-tree.hpp>
 
 namespace Astl {
 
+/* current generation of cached hash values, 0 is never current */
+static std::atomic<std::size_t> current_hash_generation(1);
+
 // constructors ==============================================================
 
 Node::Node() :
-      at(std::make_shared<Attribute>()), leaf(true), context(nullptr) {
+      context(nullptr), hashval(0), hash_generation(0),
+      leaf(true), shared(false), token() {
 }
 
 Node::Node(const Node& other) :
-      loc(other.loc),
-      at(std::make_shared<Attribute>()),
-      leaf(other.leaf),
-      context(nullptr),
-      token(other.token),
-      op(other.op), subnodes(other.subnodes) {
+      loc(other.loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(other.leaf), shared(false) {
+   if (leaf) {
+      new (&token) Token(other.token);
+   } else {
+      new (&opnode) OperatorNode(other.opnode);
+   }
 }
 
 Node::Node(const Location& loc, const Token& token) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(true),
-      context(nullptr), token(token) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(true), shared(false), token(token) {
 }
 
 Node::Node(const Location& loc, const Operator& op) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
 }
 
 Node::Node(const Location& loc, const Operator& op, NodePtr subnode) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
    assert(subnode);
-   subnodes.push_back(subnode);
+   opnode.subnodes.push_back(subnode);
 }
 
 Node::Node(const Location& loc, const Operator& op,
 	 NodePtr subnode1, NodePtr subnode2) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
    assert(subnode1); assert(subnode2);
-   subnodes.push_back(subnode1);
-   subnodes.push_back(subnode2);
+   opnode.subnodes.reserve(2);
+   opnode.subnodes.push_back(subnode1);
+   opnode.subnodes.push_back(subnode2);
 }
 
 Node::Node(const Location& loc, const Operator& op,
 	 NodePtr subnode1, NodePtr subnode2, NodePtr subnode3) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
    assert(subnode1); assert(subnode2); assert(subnode3);
-   subnodes.push_back(subnode1);
-   subnodes.push_back(subnode2);
-   subnodes.push_back(subnode3);
+   opnode.subnodes.reserve(3);
+   opnode.subnodes.push_back(subnode1);
+   opnode.subnodes.push_back(subnode2);
+   opnode.subnodes.push_back(subnode3);
 }
 
 Node::Node(const Location& loc, const Operator& op,
 	 NodePtr subnode1, NodePtr subnode2, NodePtr subnode3,
 	 NodePtr subnode4) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
    assert(subnode1); assert(subnode2); assert(subnode3); assert(subnode4);
-   subnodes.push_back(subnode1);
-   subnodes.push_back(subnode2);
-   subnodes.push_back(subnode3);
-   subnodes.push_back(subnode4);
+   opnode.subnodes.reserve(4);
+   opnode.subnodes.push_back(subnode1);
+   opnode.subnodes.push_back(subnode2);
+   opnode.subnodes.push_back(subnode3);
+   opnode.subnodes.push_back(subnode4);
 }
 
 Node::Node(const Location& loc, const Operator& op,
 	 NodePtr subnode1, NodePtr subnode2, NodePtr subnode3,
 	 NodePtr subnode4, NodePtr subnode5) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
    assert(subnode1); assert(subnode2); assert(subnode3);
    assert(subnode4); assert(subnode5);
-   subnodes.push_back(subnode1);
-   subnodes.push_back(subnode2);
-   subnodes.push_back(subnode3);
-   subnodes.push_back(subnode4);
-   subnodes.push_back(subnode5);
+   opnode.subnodes.reserve(5);
+   opnode.subnodes.push_back(subnode1);
+   opnode.subnodes.push_back(subnode2);
+   opnode.subnodes.push_back(subnode3);
+   opnode.subnodes.push_back(subnode4);
+   opnode.subnodes.push_back(subnode5);
 }
 
 Node::Node(const Location& loc, const Operator& op,
 	 NodePtr subnode1, NodePtr subnode2, NodePtr subnode3,
 	 NodePtr subnode4, NodePtr subnode5, NodePtr subnode6) :
-      loc(loc), at(std::make_shared<Attribute>()), leaf(false),
-      context(nullptr), op(op) {
+      loc(loc), context(nullptr), hashval(0), hash_generation(0),
+      leaf(false), shared(false), opnode(op) {
    assert(subnode1); assert(subnode2); assert(subnode3);
    assert(subnode4); assert(subnode5); assert(subnode6);
-   subnodes.push_back(subnode1);
-   subnodes.push_back(subnode2);
-   subnodes.push_back(subnode3);
-   subnodes.push_back(subnode4);
-   subnodes.push_back(subnode5);
-   subnodes.push_back(subnode6);
+   opnode.subnodes.reserve(6);
+   opnode.subnodes.push_back(subnode1);
+   opnode.subnodes.push_back(subnode2);
+   opnode.subnodes.push_back(subnode3);
+   opnode.subnodes.push_back(subnode4);
+   opnode.subnodes.push_back(subnode5);
+   opnode.subnodes.push_back(subnode6);
 }
 
 // destructor ================================================================
 Node::~Node() {
+   if (leaf) {
+      token.~Token();
+   } else {
+      opnode.~OperatorNode();
+   }
 }
 
 // accessors =================================================================
@@ -126,6 +144,9 @@ const Location& Node::get_location() const {
 }
 
 AttributePtr Node::get_attribute() const {
+   if (!at) {
+      at = std::make_shared<Attribute>();
+   }
    return at;
 }
 
@@ -134,10 +155,18 @@ void Node::set_attribute(AttributePtr newat) {
    at = newat;
 }
 
+bool Node::has_attributes() const {
+   return at && at->size() > 0;
+}
+
 bool Node::is_leaf() const {
    return leaf;
 }
 
+bool Node::is_shared() const {
+   return shared;
+}
+
 const Token& Node::get_token() const {
    assert(leaf);
    return token;
@@ -145,37 +174,78 @@ const Token& Node::get_token() const {
 
 Operator Node::get_op() const {
    assert(!leaf);
-   return op;
+   return opnode.op;
 }
 
 std::size_t Node::size() const {
    assert(!leaf);
-   return subnodes.size();
+   return opnode.subnodes.size();
 }
 
 const NodePtr& Node::get_operand(std::size_t index) const {
-   assert(!leaf && index < subnodes.size());
-   return subnodes[index];
+   assert(!leaf && index < opnode.subnodes.size());
+   return opnode.subnodes[index];
 }
 
 // mutators ==================================================================
 
+/* other may be kept alive by our own subnodes only,
+   hence everything is copied before our subnodes are released */
 Node& Node::operator=(const Node& other) {
-   leaf = other.leaf; token = other.token;
-   op = other.op; subnodes = other.subnodes;
+   assert(!shared);
+   modified();
+   if (leaf && other.leaf) {
+      token = other.token;
+   } else if (!leaf && !other.leaf) {
+      OperatorNode copy(other.opnode);
+      opnode.op = copy.op; opnode.subnodes.swap(copy.subnodes);
+   } else if (other.leaf) {
+      Token copy(other.token);
+      opnode.~OperatorNode();
+      new (&token) Token(copy);
+      leaf = true;
+   } else {
+      token.~Token();
+      new (&opnode) OperatorNode(other.opnode);
+      leaf = false;
+   }
    context = nullptr;
    return *this;
 }
 
 Node& Node::operator+=(NodePtr subnode) {
-   assert(!leaf && subnode != nullptr);
-   subnodes.push_back(subnode);
+   assert(!leaf && !shared && subnode != nullptr);
+   modified();
+   opnode.subnodes.push_back(subnode);
    return *this;
 }
 
 NodePtr& Node::get_operand(std::size_t index) {
-   assert(!leaf && index < subnodes.size());
-   return subnodes[index];
+   assert(!leaf && index < opnode.subnodes.size());
+   /* cached hash values are not invalidated as this is
+      also used for read accesses, see invalidate_hashes() */
+   return opnode.subnodes[index];
+}
+
+void Node::set_operand(std::size_t index, NodePtr subnode) {
+   assert(!leaf && !shared && index < opnode.subnodes.size());
+   assert(subnode != nullptr);
+   modified();
+   opnode.subnodes[index] = subnode;
+}
+
+/* invalidate all cached hash values if our hash value is cached;
+   otherwise no cached hash value can depend on this node as
+   all subtrees are hashed before their parents */
+void Node::modified() {
+   if (hash_generation.load(std::memory_order_relaxed) ==
+	 current_hash_generation) {
+      invalidate_hashes();
+   }
+}
+
+void Node::invalidate_hashes() {
+   ++current_hash_generation;
 }
 
 // context ===================================================================
@@ -189,20 +259,77 @@ Context& Node::get_context() {
    return *context;
 }
 
+void Node::clear_contexts() {
+   std::vector<Node*> stack;
+   stack.push_back(this);
+   while (stack.size() > 0) {
+      Node* node = stack.back(); stack.pop_back();
+      node->context = nullptr;
+      if (!node->leaf) {
+	 for (auto& subnode: node->opnode.subnodes) {
+	    if (subnode) stack.push_back(subnode.get());
+	 }
+      }
+   }
+}
+
 // comparison ================================================================
 
 bool Node::deep_tree_equality(NodePtr other) const {
    if (this == &(*other)) return true;
    if (leaf != other->leaf) return false;
-   if (leaf) return token.get_text() == other->token.get_text();
-   if (op != other->op) return false;
-   if (subnodes.size() != other->subnodes.size()) return false;
-   for (std::size_t i = 0; i < subnodes.size(); ++i) {
-      if (!subnodes[i]->deep_tree_equality(other->subnodes[i])) return false;
+   /* token texts are interned, see token.hpp */
+   if (leaf) return &token.get_text() == &other->token.get_text();
+   if (opnode.op != other->opnode.op) return false;
+   if (opnode.subnodes.size() != other->opnode.subnodes.size()) return false;
+   /* hash values are compared only if both are cached already
+      as their computation would visit both trees entirely */
+   std::size_t h1, h2;
+   if (cached_hash(h1) && other->cached_hash(h2) && h1 != h2) return false;
+   for (std::size_t i = 0; i < opnode.subnodes.size(); ++i) {
+      const NodePtr& subnode(opnode.subnodes[i]);
+      if (!subnode->deep_tree_equality(other->opnode.subnodes[i])) {
+	 return false;
+      }
+   }
+   return true;
+}
+
+static inline std::size_t combine_hash(std::size_t h1, std::size_t h2) {
+   return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+}
+
+/* the cache may be filled concurrently by multiple threads which
+   compute the same value; hashval is stored before hash_generation
+   is released such that a current generation implies a valid hashval */
+bool Node::cached_hash(std::size_t& h) const {
+   if (hash_generation.load(std::memory_order_acquire) !=
+	 current_hash_generation) {
+      return false;
    }
+   h = hashval.load(std::memory_order_relaxed);
    return true;
 }
 
+std::size_t Node::hash() const {
+   std::size_t generation = current_hash_generation;
+   std::size_t h;
+   if (cached_hash(h)) return h;
+   if (leaf) {
+      h = combine_hash(1, std::hash<std::string>()(token.get_text()));
+   } else {
+      /* operators are compared by name if one of them has no opcode */
+      const char* name = opnode.op.get_name();
+      h = combine_hash(2, std::hash<std::string>()(name));
+      for (auto& subnode: opnode.subnodes) {
+	 h = combine_hash(h, subnode->hash());
+      }
+   }
+   hashval.store(h, std::memory_order_relaxed);
+   hash_generation.store(generation, std::memory_order_release);
+   return h;
+}
+
 bool deep_tree_equality(NodePtr node1, NodePtr node2) {
    return node1->deep_tree_equality(node2);
 }
@@ -241,4 +368,95 @@ std::ostream& operator<<(std::ostream& out, NodePtr snode) {
    return out;
 }
 
+// memory usage ==============================================================
+
+/* approximations: the reference counts of a shared object
+   created by make_shared and the node of an unordered set */
+static constexpr std::size_t shared_overhead = 2 * sizeof(void*);
+static constexpr std::size_t set_node_overhead = 2 * sizeof(void*);
+/* a node of a red-black tree */
+static constexpr std::size_t map_node_overhead = 4 * sizeof(void*);
+
+static std::size_t string_size(const std::string& s) {
+   std::size_t size = sizeof(std::string);
+   const char* data = s.data();
+   const char* sp = reinterpret_cast<const char*>(&s);
+   /* short strings are kept within the string object */
+   if (data < sp || data >= sp + sizeof(std::string)) {
+      size += s.capacity() + 1;
+   }
+   return size;
+}
+
+TreeMemoryUsage get_memory_usage(NodePtr root) {
+   TreeMemoryUsage usage;
+   std::unordered_set<const Node*> visited;
+   std::unordered_set<const std::string*> strings;
+   auto add_string = [&](const std::string& s) {
+      if (!s.empty() && strings.insert(&s).second) {
+	 usage.string_bytes += string_size(s) + set_node_overhead;
+      }
+   };
+   std::vector<const Node*> stack;
+   stack.push_back(root.get());
+   while (stack.size() > 0) {
+      const Node* node = stack.back(); stack.pop_back();
+      if (!visited.insert(node).second) continue;
+      usage.node_bytes += sizeof(Node) + shared_overhead;
+      if (node->at) {
+	 usage.attribute_bytes += sizeof(Attribute) + shared_overhead;
+	 if (node->at->get_type() == Attribute::dictionary) {
+	    usage.attribute_bytes += node->at->size() *
+	       (sizeof(Attribute::Dictionary::value_type) +
+		  map_node_overhead);
+	 }
+      }
+      if (node->context) {
+	 usage.context_bytes += sizeof(Context);
+      }
+      if (node->leaf) {
+	 ++usage.leaves;
+	 add_string(node->token.get_text());
+	 add_string(node->token.get_literal());
+      } else {
+	 ++usage.operator_nodes;
+	 usage.subnode_bytes +=
+	    node->opnode.subnodes.capacity() * sizeof(NodePtr);
+	 for (auto& subnode: node->opnode.subnodes) {
+	    if (subnode) stack.push_back(subnode.get());
+	 }
+      }
+   }
+   return usage;
+}
+
+std::size_t TreeMemoryUsage::nodes() const {
+   return leaves + operator_nodes;
+}
+
+std::size_t TreeMemoryUsage::bytes() const {
+   return node_bytes + subnode_bytes + attribute_bytes +
+      context_bytes + string_bytes;
+}
+
+std::ostream& operator<<(std::ostream& out, const TreeMemoryUsage& usage) {
+   std::size_t nodes = usage.nodes();
+   auto line = [&](const char* what, std::size_t bytes) {
+      out << what << ": " << bytes << " bytes";
+      if (nodes > 0) {
+	 out << ", " << (double) bytes / nodes << " bytes per node";
+      }
+      out << std::endl;
+   };
+   out << "nodes: " << nodes << " (" << usage.leaves << " leaves, " <<
+      usage.operator_nodes << " operator nodes)" << std::endl;
+   line("node objects", usage.node_bytes);
+   line("operand vectors", usage.subnode_bytes);
+   line("attributes", usage.attribute_bytes);
+   line("contexts", usage.context_bytes);
+   line("token strings", usage.string_bytes);
+   line("total", usage.bytes());
+   return out;
+}
+
 } // namespace Astl
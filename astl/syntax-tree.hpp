@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010, 2016 Andreas F. Borchert
+   Copyright (C) 2009, 2010, 2016, 2026 Andreas F. Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,6 +19,7 @@
 #ifndef ASTL_SYNTAX_TREE_H
 #define ASTL_SYNTAX_TREE_H
 
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
@@ -32,6 +33,8 @@
 
 namespace Astl {
 
+   struct TreeMemoryUsage;
+
    /**
     * A syntax tree is represented by a node which, if it
     * is not a leaf node, has one or more subnodes which
@@ -53,9 +56,9 @@ namespace Astl {
     *
     * Just a few mutators are supported: Nodes can be assigned to
     * and operands can be added to an operator node. Individual
-    * subnodes (or operands) can be replaced by retrieving a
-    * NodePtr reference through get_operand() and then by assigning
-    * another subnode to it.
+    * subnodes (or operands) can be replaced by set_operand() or
+    * by retrieving a NodePtr reference through get_operand() and
+    * then by assigning another subnode to it (see invalidate_hashes()).
     *
     * The creation of cyclic references is not permitted (but also
     * not checked for). Shared references to the same subnode are
@@ -113,11 +116,25 @@ namespace Astl {
 	  */
 	 void set_attribute(AttributePtr newat);
 
+	 /**
+	  * Returns true if the attribute of the node has any entries.
+	  * Unlike get_attribute() this does not create the attribute.
+	  */
+	 bool has_attributes() const;
+
 	 /**
 	  * Returns true for leaf nodes that represent lexical tokens.
 	  */
 	 bool is_leaf() const;
 
+	 /**
+	  * Returns true if the node has been returned by a
+	  * SubtreeTable (see subtree-table.hpp) for more than
+	  * one occurrence, i.e. if it is possibly shared by
+	  * multiple parents. Shared nodes must not be modified.
+	  */
+	 bool is_shared() const;
+
 	 // ===== accessors for leaf nodes =====
 	 /**
 	  * This accessor is restricted to leaf nodes representing
@@ -156,31 +173,84 @@ namespace Astl {
 	 Node& operator+=(NodePtr subnode1);
 
 	 /**
-	  * This mutator is restricted to operator nodes
-	  * and allows to replace the index-th operand.
+	  * This accessor is restricted to operator nodes
+	  * and returns a reference to the index-th operand
+	  * through which it may be replaced. Cached hash values
+	  * are not invalidated by this (see invalidate_hashes()).
 	  */
 	 NodePtr& get_operand(std::size_t index);
 
+	 /**
+	  * This mutator is restricted to operator nodes
+	  * and replaces the index-th operand.
+	  */
+	 void set_operand(std::size_t index, NodePtr subnode);
+
 	 void set_context(const Context& context_param);
 	 Context& get_context();
+	 /**
+	  * Drop the contexts of this node and all of its subnodes.
+	  * Contexts refer to the ancestors of a node, i.e. a
+	  * tree that has been traversed by a candidate set is
+	  * kept alive by reference cycles until this is done.
+	  */
+	 void clear_contexts();
 
 	 bool deep_tree_equality(NodePtr other) const;
 
+	 /**
+	  * Return a structural hash value of the tree
+	  * which depends on the operators, the token texts,
+	  * and the order of the subtrees only. Trees that are
+	  * considered equal by deep_tree_equality have the
+	  * same hash value. Hash values are computed when
+	  * needed and cached within the nodes.
+	  */
+	 std::size_t hash() const;
+
+	 /**
+	  * All cached hash values are invalidated whenever
+	  * a node with a valid cached hash value is modified
+	  * through one of the mutators above. This function
+	  * must be called when a subtree is replaced through
+	  * a reference that has been retrieved by get_operand().
+	  */
+	 static void invalidate_hashes();
+
       private:
 	 Location loc;
-	 AttributePtr at;
-	 bool leaf;
+	 /* the attribute is created when it is asked for
+	    as most nodes never get any attributes */
+	 mutable AttributePtr at;
 
 	 /* declared as pointer to save space when it is not required:
 	    on a 64 bit architecture we just need 8 instead of 48 bytes */
 	 std::unique_ptr<Context> context;
 
-	 // leaf node
-	 Token token;
+	 // cached hash value, valid if hash_generation is current
+	 mutable std::atomic<std::size_t> hashval;
+	 mutable std::atomic<std::size_t> hash_generation;
+
+	 /* leaf nodes need just a token, operator nodes just
+	    an operator and their subnodes, hence both share
+	    the same storage, selected by leaf */
+	 struct OperatorNode {
+	    OperatorNode(const Operator& op) : op(op) {}
+	    Operator op;
+	    std::vector<NodePtr> subnodes;
+	 };
+	 bool leaf;
+	 bool shared; // see is_shared()
+	 union {
+	    Token token; // leaf node
+	    OperatorNode opnode; // operator node
+	 };
+
+	 void modified();
+	 bool cached_hash(std::size_t& h) const;
 
-	 // operator node
-	 Operator op;
-	 std::vector<NodePtr> subnodes;
+	 friend TreeMemoryUsage get_memory_usage(NodePtr root);
+	 friend class SubtreeTable;
    };
    bool deep_tree_equality(NodePtr node1, NodePtr node2);
 
@@ -194,6 +264,26 @@ namespace Astl {
     */
    std::ostream& operator<<(std::ostream& out, NodePtr node);
 
+   /**
+    * Approximate memory usage of a tree, not counting the
+    * overhead of the memory allocator. Shared subtrees and
+    * shared strings are counted just once.
+    */
+   struct TreeMemoryUsage {
+      std::size_t leaves = 0;
+      std::size_t operator_nodes = 0;
+      std::size_t node_bytes = 0; // nodes including reference counts
+      std::size_t subnode_bytes = 0; // operand vectors of operator nodes
+      std::size_t attribute_bytes = 0; // attribute dictionaries
+      std::size_t context_bytes = 0;
+      std::size_t string_bytes = 0; // token texts and literals
+
+      std::size_t nodes() const;
+      std::size_t bytes() const;
+   };
+   TreeMemoryUsage get_memory_usage(NodePtr root);
+   std::ostream& operator<<(std::ostream& out, const TreeMemoryUsage& usage);
+
 } // namespace Astl
 
 #endif
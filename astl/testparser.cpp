@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -17,6 +17,7 @@
 */
 
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -29,6 +30,8 @@
 #include <astl/rule-table.hpp>
 #include <astl/rules.hpp>
 #include <astl/scanner.hpp>
+#include <astl/subtree-table.hpp>
+#include <astl/syntax-tree.hpp>
 #include <astl/token.hpp>
 #include <astl/yytname.hpp>
 
@@ -37,8 +40,13 @@ using namespace Astl;
 
 int main(int argc, char** argv) {
    char* cmdname = *argv++; --argc;
+   /* -m: print the memory usage of the tree instead of the tree */
+   bool memory_usage = false;
+   if (argc > 0 && strcmp(*argv, "-m") == 0) {
+      memory_usage = true; ++argv; --argc;
+   }
    if (argc > 1) {
-      cerr << "Usage: " << cmdname << " [filename]" << endl;
+      cerr << "Usage: " << cmdname << " [-m] [filename]" << endl;
       exit(1);
    }
 
@@ -62,6 +70,10 @@ int main(int argc, char** argv) {
       NodePtr root;
       parser p(*scanner, root);
       if (p.parse() == 0) {
+	 if (memory_usage) {
+	    cout << get_memory_usage(share_subtrees(root));
+	    return 0;
+	 }
 	 cout << root << endl;
       }
 
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -24,6 +24,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <astl/intern.hpp>
 
 namespace Astl {
 
@@ -58,6 +59,11 @@ namespace Astl {
     *    identical, or,
     *  - in case at least one of them has no well-defined symbol number,
     *    if their content is identical.
+    *
+    * Token strings are interned (see intern.hpp), i.e. tokens with
+    * the same contents share the same string object and the literal
+    * representation costs nothing extra if it agrees with the contents.
+    * Interned strings are released by the last token referring to them.
     */
 
    class Token {
@@ -68,14 +74,15 @@ namespace Astl {
 	  * a well-defined symbol number and without a
 	  * a well-defined string representation.
 	  */
-	 Token() : token(0), tokenval(), tokenlit() {
+	 Token() : token(0), tokenval(nullptr), tokenlit(nullptr) {
 	 }
 
 	 /**
 	  * Construct a simple token with the given symbol value
 	  * but with an empty string representation.
 	  */
-	 Token(unsigned int token) : token(token), tokenval(""), tokenlit("") {
+	 Token(unsigned int token) :
+	       token(token), tokenval(nullptr), tokenlit(nullptr) {
 	    assert(token != 0);
 	 }
 
@@ -84,7 +91,8 @@ namespace Astl {
 	  * contents which is also taken as its literal representation.
 	  */
 	 Token(const std::string& tokenval) :
-	       token(0), tokenval(tokenval), tokenlit(tokenval) {
+	       token(0), tokenval(intern_string(tokenval)),
+	       tokenlit(retain_interned_string(this->tokenval)) {
 	 }
 
 	 /**
@@ -93,7 +101,8 @@ namespace Astl {
 	  * representation.
 	  */
 	 Token(unsigned int token, const std::string& tokenval) :
-	       token(token), tokenval(tokenval), tokenlit(tokenval) {
+	       token(token), tokenval(intern_string(tokenval)),
+	       tokenlit(retain_interned_string(this->tokenval)) {
 	    assert(token != 0);
 	 }
 
@@ -105,7 +114,8 @@ namespace Astl {
 	  * copied.
 	  */
 	 Token(unsigned int token, std::unique_ptr<std::string> tokenval) :
-	       token(token), tokenval(*tokenval), tokenlit(*tokenval) {
+	       token(token), tokenval(intern_string(*tokenval)),
+	       tokenlit(retain_interned_string(this->tokenval)) {
 	    assert(token != 0 && tokenval != nullptr);
 	 }
 
@@ -115,7 +125,8 @@ namespace Astl {
 	  */
 	 Token(unsigned int token,
 		  const std::string& tokenval, const std::string& tokenlit) :
-	       token(token), tokenval(tokenval), tokenlit(tokenlit) {
+	       token(token), tokenval(intern_string(tokenval)),
+	       tokenlit(intern_string(tokenlit)) {
 	    assert(token != 0);
 	 }
 
@@ -127,7 +138,8 @@ namespace Astl {
 	  */
 	 Token(unsigned int token,
 	       std::string tokenval, std::unique_ptr<std::string> tokenlit) :
-	       token(token), tokenval(tokenval), tokenlit(*tokenlit) {
+	       token(token), tokenval(intern_string(tokenval)),
+	       tokenlit(intern_string(*tokenlit)) {
 	    assert(token != 0);
 	 }
 
@@ -135,8 +147,26 @@ namespace Astl {
 	  * Copy constructor for tokens.
 	  */
 	 Token(const Token& other) :
+	    token(other.token),
+	    tokenval(retain_interned_string(other.tokenval)),
+	    tokenlit(retain_interned_string(other.tokenlit)) {
+	 }
+
+	 /**
+	  * Move constructor for tokens.
+	  */
+	 Token(Token&& other) :
 	    token(other.token), tokenval(other.tokenval),
 	    tokenlit(other.tokenlit) {
+	    other.tokenval = other.tokenlit = nullptr;
+	 }
+
+	 /**
+	  * Release the interned strings of the token.
+	  */
+	 ~Token() {
+	    release_interned_string(tokenval);
+	    release_interned_string(tokenlit);
 	 }
 
 	 // accessors
@@ -150,12 +180,19 @@ namespace Astl {
 	    return token;
 	 }
 
+	 /**
+	  * Return true if the token has a well-defined symbol value.
+	  */
+	 bool has_tokenval() const {
+	    return token != 0;
+	 }
+
 	 /**
 	  * Return the contents of token. This is empty in case
 	  * it is not well-defined.
 	  */
 	 const std::string& get_text() const {
-	    return tokenval;
+	    return tokenval? tokenval->text: empty_string();
 	 }
 
 	 /**
@@ -163,7 +200,7 @@ namespace Astl {
 	  * is the empty string if it is not well-defined.
 	  */
 	 const std::string& get_literal() const {
-	    return tokenlit;
+	    return tokenlit? tokenlit->text: empty_string();
 	 }
 
 	 /**
@@ -173,6 +210,7 @@ namespace Astl {
 	 bool operator==(const Token& other) const {
 	    return (token && other.token && token == other.token) ||
 	       ((token == 0 || other.token == 0) &&
+		  /* interned strings are equal iff their addresses are */
 		  (tokenval == other.tokenval));
 	 }
 
@@ -190,6 +228,8 @@ namespace Astl {
 	  */
 	 Token& operator=(const Token& other) {
 	    token = other.token;
+	    retain_interned_string(other.tokenval);
+	    release_interned_string(tokenval);
 	    tokenval = other.tokenval;
 	    return *this;
 	 }
@@ -198,20 +238,30 @@ namespace Astl {
 	  * Update the literal representation of a token.
 	  */
          void set_literal(std::string tokenlit_param) {
-            tokenlit = tokenlit_param;
+            const InternedString* old = tokenlit;
+            tokenlit = intern_string(tokenlit_param);
+            release_interned_string(old);
          }
 
 	 /**
 	  * Update the contents of a token.
 	  */
          void set_text(std::string tokenval_param) {
-            tokenval = tokenval_param;
+            const InternedString* old = tokenval;
+            tokenval = intern_string(tokenval_param);
+            release_interned_string(old);
          }
 
       private:
 	 unsigned int token; // symbol from lexical analysis
-	 std::string tokenval; // actual token string
-	 std::string tokenlit; // literal form of token
+	 /* interned strings, nullptr for empty strings */
+	 const InternedString* tokenval; // actual token string
+	 const InternedString* tokenlit; // literal form of token
+
+	 static const std::string& empty_string() {
+	    static const std::string empty;
+	    return empty;
+	 }
    };
 
    /**
@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009, 2010 Andreas Franz Borchert
+   Copyright (C) 2009, 2010, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -20,49 +20,30 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <astl/intern.hpp>
 #include <astl/treeloc.hpp>
 
 namespace Astl {
 
 // implementation of Position ===============================================
 
-static StringPtr get_string(const std::string* sp) {
-   static bool s_defined = false;
-   static std::string last_s;
-   static StringPtr last_ptr;
-   if (sp) {
-      if (!s_defined || *sp != last_s) {
-	 last_ptr = std::make_shared<std::string>(*sp);
-	 last_s = *sp;
-	 s_defined = true;
-      }
-      return last_ptr;
-   } else {
-      return StringPtr(nullptr);
-   }
-}
-
 // constructors -------------------------------------------------------------
 
-Position::Position() : line(0), column(0), filename_defined(false) {};
+Position::Position() : file(0), line(0), column(0) {};
 
 Position::Position(const position& pos) :
-      line(pos.line), column(pos.column),
-      filename_defined(pos.filename != 0),
-      filename(get_string(pos.filename)) {
+      file(pos.filename? intern_filename(*pos.filename): 0),
+      line(pos.line), column(pos.column) {
 }
 
 Position::Position(const std::string* filename_param,
       std::size_t line_param, std::size_t column_param) :
-      line(line_param), column(column_param),
-      filename_defined(filename_param != 0),
-      filename(get_string(filename_param)) {
+      file(filename_param? intern_filename(*filename_param): 0),
+      line(line_param), column(column_param) {
 }
 
 Position::Position(const Position& other) :
-      line(other.line), column(other.column),
-      filename_defined(other.filename_defined),
-      filename(other.filename) {
+      file(other.file), line(other.line), column(other.column) {
 }
 
 // accessors ----------------------------------------------------------------
@@ -76,12 +57,12 @@ std::size_t Position::get_column() const {
 }
 
 bool Position::is_filename_defined() const {
-   return filename_defined;
+   return file != 0;
 }
 
 const std::string& Position::get_filename() const {
-   assert(filename_defined);
-   return *filename;
+   assert(file != 0);
+   return get_interned_filename(file);
 }
 
 // operators ----------------------------------------------------------------
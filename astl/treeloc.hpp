@@ -1,5 +1,5 @@
 /*
-   Copyright (C) 2009 Andreas Franz Borchert
+   Copyright (C) 2009, 2026 Andreas Franz Borchert
    ----------------------------------------------------------------------------
    The Astl Library is free software; you can redistribute it
    and/or modify it under the terms of the GNU Library General Public
@@ -19,6 +19,7 @@
 #ifndef ASTL_TREELOC_H
 #define ASTL_TREELOC_H
 
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
@@ -33,6 +34,12 @@ namespace Astl {
    class position;
    class location;
 
+   /*
+      Positions are kept compact as they are stored twice
+      per syntax tree node: filenames are interned and
+      represented by their id (see intern.hpp) where 0
+      stands for an undefined filename.
+   */
    class Position {
       public:
 	 // constructors
@@ -54,10 +61,9 @@ namespace Astl {
 	 Position& operator-=(Offset decr);
 
       private:
-	 std::size_t line;
-	 std::size_t column;
-	 bool filename_defined;
-	 StringPtr filename;
+	 std::uint32_t file;
+	 std::uint32_t line;
+	 std::uint32_t column;
    };
 
    class Location {